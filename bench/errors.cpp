@@ -0,0 +1,168 @@
+// error unions as lowered by nukac::lower against C++ exceptions.
+//
+// source below goes through the frontend and the Lowerer, and the
+// instructions for chain are printed first. nukac has no backend yet
+// and nuka has no if, so tagged::chain is a model of that listing
+// written out by hand: one tag compare per try, with the errdefer and
+// then the defer copied in front of every propagation. step is only
+// declared in nuka, both sides use the C++ one.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "../src/lexer.hpp"
+#include "../src/lower.hpp"
+#include "../src/parser.hpp"
+#include "../src/sema.hpp"
+
+namespace {
+  using i64 = int64_t;
+  using u16 = uint16_t;
+
+  const char *source = R"(
+error ParseError { Negative, Overflow }
+
+cleanups: i64 = 0;
+failures: i64 = 0;
+
+fn ParseError!i64 step(x: i64);
+
+fn ParseError!i64 chain(x: i64) {
+  defer cleanups = cleanups + 1;
+  errdefer failures = failures + 1;
+  a: i64 = try step(x);
+  b: i64 = try step(a - 1);
+  c: i64 = try step(b - 1);
+  return c;
+}
+)";
+
+  // false if source doesn't check, the model would be of nothing.
+  bool printLowered() {
+    std::istringstream in(source);
+    nukac::lexer::Lexer lexer(in);
+    nukac::parser::Parser parser(lexer);
+    nukac::sema::Analyzer analyzer(parser);
+    for(const nukac::sema::Diagnostic &diagnostic: analyzer.getDiagnostics())
+      std::cout << "source:" << diagnostic << "\n";
+    if(analyzer.hasErrors()) return false;
+
+    for(const nukac::parser::ast::Function &function: parser.getFunctions()) {
+      if(function.getPrototype().getName() != "chain") continue;
+      nukac::lower::Lowerer lowerer(nukac::lower::statementsOf(function.getBody()));
+      std::cout << "chain lowers to\n";
+      for(const nukac::lower::Instruction &instruction: lowerer.getInstructions())
+        std::cout << "  " << instruction << "\n";
+    }
+    std::cout << "\n";
+    return true;
+  }
+
+  constexpr i64 limit = 1 << 20;
+  constexpr i64 offset = 1;
+  constexpr int iterations = 2000000;
+
+  i64 cleanups = 0;
+  i64 failures = 0;
+
+  namespace tagged {
+    enum : u16 { ok = 0, negative = 1, overflow = 2 };
+
+    struct ErrorUnion {
+      u16 tag;
+      i64 value;
+    };
+
+    [[gnu::noinline]] ErrorUnion step(i64 x) {
+      if(x < 0) return { negative, 0 };
+      if(x > limit) return { overflow, 0 };
+      return { ok, x * 3 + 1 };
+    }
+
+    [[gnu::noinline]] ErrorUnion chain(i64 x) {
+      ErrorUnion a = step(x);
+      if(a.tag != ok) { failures++; cleanups++; return { a.tag, 0 }; }
+      ErrorUnion b = step(a.value - offset);
+      if(b.tag != ok) { failures++; cleanups++; return { b.tag, 0 }; }
+      ErrorUnion c = step(b.value - offset);
+      if(c.tag != ok) { failures++; cleanups++; return { c.tag, 0 }; }
+      cleanups++;
+      return { ok, c.value };
+    }
+  } // tagged
+
+  namespace exceptions {
+    struct Negative {};
+    struct Overflow {};
+
+    [[gnu::noinline]] i64 step(i64 x) {
+      if(x < 0) throw Negative{};
+      if(x > limit) throw Overflow{};
+      return x * 3 + 1;
+    }
+
+    [[gnu::noinline]] i64 chain(i64 x) {
+      struct Defer { ~Defer() { cleanups++; } } defer;
+      try {
+        i64 a = step(x);
+        i64 b = step(a - offset);
+        return step(b - offset);
+      } catch(...) {
+        failures++;
+        throw;
+      }
+    }
+  } // exceptions
+
+  std::vector<i64> inputs(double error_rate) {
+    std::mt19937_64 random(42);
+    std::bernoulli_distribution fails(error_rate);
+    std::uniform_int_distribution<i64> value(0, 1000);
+
+    std::vector<i64> in(iterations);
+    for(i64 &x: in) x = fails(random) ? -value(random) - 1 : value(random);
+    return in;
+  }
+
+  template <typename F>
+  double nanosecondsPerCall(const std::vector<i64> &in, F &&f) {
+    const auto begin = std::chrono::steady_clock::now();
+    for(i64 x: in) f(x);
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / in.size();
+  }
+} // anonymous
+
+int main() {
+  if(!printLowered()) return 1;
+  std::printf("%-12s %14s %14s\n", "error rate", "tagged ns", "exceptions ns");
+
+  for(double error_rate: { 0.0, 0.001, 0.01, 0.1, 0.5 }) {
+    const std::vector<i64> in = inputs(error_rate);
+    i64 sink = 0;
+
+    const double tagged_ns = nanosecondsPerCall(in, [&](i64 x) {
+      tagged::ErrorUnion r = tagged::chain(x);
+      if(r.tag == tagged::ok) sink += r.value;
+      else sink -= r.tag;
+    });
+
+    const double exceptions_ns = nanosecondsPerCall(in, [&](i64 x) {
+      try {
+        sink += exceptions::chain(x);
+      } catch(exceptions::Negative &) {
+        sink -= 1;
+      } catch(exceptions::Overflow &) {
+        sink -= 2;
+      }
+    });
+
+    std::printf("%-12g %14.2f %14.2f\n", error_rate, tagged_ns, exceptions_ns);
+    if(sink == 42) std::printf("\n");
+  }
+}
@@ -0,0 +1,67 @@
+// eager against lazy function bodies, parse and sema of a module where
+// main only reaches a few of its functions.
+//
+//   fn u64 f0(a: u64, b: u64) {
+//     c: u64 = a * b + 3;
+//     d: u64 = c - a / 2;
+//     c = d + f1(a, b);
+//     return c + d;
+//   }
+//   ...
+//   fn void main() {
+//     x: u64 = f0(1, 2);
+//   }
+//
+// each fN calls fN+1 up to reached, the rest are only declared.
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "../src/lexer.hpp"
+#include "../src/parser.hpp"
+#include "../src/sema.hpp"
+
+namespace {
+  constexpr usize functions = 20000;
+  constexpr usize reached = 16;
+  constexpr int iterations = 5;
+
+  std::string source() {
+    std::ostringstream os;
+    for(usize i = 0; i < functions; i++) {
+      os << "fn u64 f" << i << "(a: u64, b: u64) {\n"
+         << "  c: u64 = a * b + 3;\n"
+         << "  d: u64 = c - a / 2;\n";
+      if(i + 1 < reached) os << "  c = d + f" << i + 1 << "(a, b);\n";
+      os << "  return c + d;\n"
+         << "}\n";
+    }
+    os << "fn void main() {\n  x: u64 = f0(1, 2);\n}\n";
+    return os.str();
+  }
+
+  double millisecondsPerRun(const std::string &src, bool lazy) {
+    double total = 0;
+    for(int i = 0; i < iterations; i++) {
+      std::istringstream is(src);
+      const auto begin = std::chrono::steady_clock::now();
+      nukac::lexer::Lexer ll(is);
+      nukac::parser::Parser pp(ll, lazy);
+      nukac::sema::Analyzer aa(pp);
+      const auto end = std::chrono::steady_clock::now();
+      if(aa.hasErrors()) std::printf("unexpected diagnostics\n");
+      total += std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+    return total / iterations;
+  }
+} // anonymous
+
+int main() {
+  const std::string src = source();
+  std::printf("%zu functions, %zu reached from main, %zu bytes\n", functions, reached, src.size());
+  std::printf("%-8s %10s\n", "bodies", "ms");
+  std::printf("%-8s %10.2f\n", "eager", millisecondsPerRun(src, false));
+  std::printf("%-8s %10.2f\n", "lazy", millisecondsPerRun(src, true));
+}
@@ -0,0 +1,184 @@
+// the table driven nukac::lexer::Lexer against the same lexer written as
+// a switch over the current character, on a generated module.
+//
+// both read the stream, validate it as UTF-8 and produce the same
+// literals. the switch side only handles ASCII words, which is all the
+// generated module has.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/lexer.hpp"
+#include "../src/unicode.hpp"
+
+namespace {
+  using nukac::lexer::Literal;
+  using nukac::lexer::Token;
+
+  constexpr usize functions = 20000;
+  constexpr int iterations = 20;
+
+  namespace switched {
+    std::vector<Literal> lex(std::istream &is) {
+      const std::string source{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+      if(usize bad; !nukac::unicode::validUtf8(source, bad)) return {};
+
+      // reserved and built in place like in the table lexer, so only the
+      // dispatch differs.
+      std::vector<Literal> literals;
+      literals.reserve(source.size() / 3 + 1);
+      const std::string_view view = source;
+      usize character = 0;
+      usize line = 1;
+      auto push = [&](Token token, usize at, std::string_view s = {}) {
+        Literal &literal = literals.emplace_back();
+        literal.where_character = at;
+        literal.where_line = line;
+        literal.literal_token = token;
+        literal.literal_string.assign(s);
+      };
+      auto word = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+      };
+
+      for(usize i = 0; i < source.size(); i++) {
+        const char c = source[i];
+        character++;
+        switch(c) {
+          case ' ': case '\t': case '\r': case '\v': case '\f': break;
+          case '\n': line++; character = 0; break;
+          case '!': push(Token::exclamation, character); break;
+          case '?': push(Token::question, character); break;
+          case '|': push(Token::pipe, character); break;
+          case '&': push(Token::ampersand, character); break;
+          case '$': push(Token::dollar, character); break;
+          case '%': push(Token::percent, character); break;
+          case '*': push(Token::star, character); break;
+          case '+': push(Token::plus, character); break;
+          case '=': push(Token::equals, character); break;
+          case '\\': push(Token::backslash, character); break;
+          case '.': push(Token::dot, character); break;
+          case ',': push(Token::comma, character); break;
+          case ':': push(Token::colon, character); break;
+          case '(': push(Token::lparen, character); break;
+          case ')': push(Token::rparen, character); break;
+          case '[': push(Token::lsqbrace, character); break;
+          case ']': push(Token::rsqbrace, character); break;
+          case '{': push(Token::lcrbrace, character); break;
+          case '}': push(Token::rcrbrace, character); break;
+          case '\'': push(Token::squote, character); break;
+          case '<': push(Token::left_inequality, character); break;
+          case '>': push(Token::right_inequality, character); break;
+          case ';': push(Token::semicolon, character); break;
+          case '-':
+            if(i + 1 < source.size() && source[i + 1] == '>') {
+              push(Token::arrow, character);
+              i++;
+              character++;
+            } else push(Token::dash, character);
+            break;
+          case '/':
+            if(i + 1 < source.size() && source[i + 1] == '/') {
+              while(i + 1 < source.size() && source[i + 1] != '\n') i++;
+            } else if(i + 1 < source.size() && source[i + 1] == '*') {
+              for(i += 2; i + 1 < source.size() && !(source[i] == '*' && source[i + 1] == '/'); i++) 
+                if(source[i] == '\n') { line++; character = 0; }
+                else character++;
+              i++;
+              character += 2;
+            } else push(Token::slash, character);
+            break;
+          case '"': {
+            const usize begin = character;
+            std::string quoted;
+            for(i++; i < source.size() && source[i] != '"'; i++, character++) {
+              if(source[i] == '\\' && i + 1 < source.size()) {
+                i++;
+                character++;
+                switch(source[i]) {
+                  case 'n': quoted.push_back('\n'); break;
+                  case 't': quoted.push_back('\t'); break;
+                  case 'r': quoted.push_back('\r'); break;
+                  case '0': quoted.push_back('\0'); break;
+                  default: quoted.push_back(source[i]);
+                }
+              } else quoted.push_back(source[i]);
+            }
+            character++;
+            push(Token::quoted, begin, quoted);
+            break;
+          }
+          default: {
+            if(!word(c)) return {};
+            const usize begin = i;
+            while(i + 1 < source.size() && word(source[i + 1])) i++;
+            push(Token::string, character, view.substr(begin, i + 1 - begin));
+            character += i - begin;
+            break;
+          }
+        }
+      }
+      return literals;
+    }
+  } // switched
+
+  std::string source() {
+    std::ostringstream os;
+    for(usize i = 0; i < functions; i++) {
+      os << "// f" << i << " mixes every token kind\n"
+         << "fn u64 f" << i << "(a: u64, b: u64) {\n"
+         << "  c: u64 = a * b + 3; /* block */\n"
+         << "  d: u64 = c - a / 2 % 7;\n"
+         << "  $println \"f" << i << " \\n\";\n"
+         << "  return c + d;\n"
+         << "}\n";
+    }
+    return os.str();
+  }
+
+  template <typename F>
+  double milliseconds(const std::string &src, F &&f) {
+    std::istringstream is(src);
+    const auto begin = std::chrono::steady_clock::now();
+    f(is);
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+  }
+} // anonymous
+
+int main() {
+  const std::string src = source();
+
+  usize table_tokens = 0;
+  usize switch_tokens = 0;
+  auto table = [&](std::istream &is) {
+    nukac::lexer::Lexer ll(is);
+    for(table_tokens = 0; !ll.isEoC(); table_tokens++) ll.swallowZ();
+  };
+  auto switched = [&](std::istream &is) {
+    switch_tokens = switched::lex(is).size();
+  };
+
+  // interleaved and the fastest run of each kept, the machine and the
+  // allocator make a mean noisy.
+  double table_ms = 0;
+  double switch_ms = 0;
+  for(int i = 0; i < iterations; i++) {
+    const double t = milliseconds(src, table);
+    const double s = milliseconds(src, switched);
+    table_ms = i == 0 ? t : std::min(table_ms, t);
+    switch_ms = i == 0 ? s : std::min(switch_ms, s);
+  }
+
+  if(table_tokens != switch_tokens)
+    std::printf("token counts differ: %zu and %zu\n", table_tokens, switch_tokens);
+  std::printf("%zu bytes, %zu tokens\n", src.size(), table_tokens);
+  std::printf("%-8s %10s %10s\n", "lexer", "ms", "MB/s");
+  std::printf("%-8s %10.2f %10.1f\n", "table", table_ms, src.size() / table_ms / 1e3);
+  std::printf("%-8s %10.2f %10.1f\n", "switch", switch_ms, src.size() / switch_ms / 1e3);
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 
 #define RED_ERROR "\033[38;2;166;17;17m"
+#define YELLOW_WARNING "\033[38;2;196;160;0m"
 #define RESET "\033[0m"
 
 #include "helper.hpp"
@@ -12,4 +13,8 @@ namespace nukac::helper {
     std::cout << std::format("{}error:{} {}\n\t...no useful hints ;-;\n", RED_ERROR, msg, RESET);
   }
 
+  void warningHandler(std::string msg) {
+    std::cout << std::format("{}warning:{} {}\n", YELLOW_WARNING, RESET, msg);
+  }
+
 }
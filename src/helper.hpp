@@ -21,6 +21,7 @@ using size = ssize_t;
 
 namespace nukac::helper {
   void exceptionHandler(std::string msg);
+  void warningHandler(std::string msg);
 
   using Value = std::variant <
     std::string,
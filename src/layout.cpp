@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <format>
+
+#include "layout.hpp"
+
+namespace nukac::layout {
+  using namespace nukac::parser;
+
+  LayoutException::LayoutException(std::string what) {
+    what_did_i_do = what;
+  }
+
+  const char *LayoutException::what() {
+    return what_did_i_do.c_str();
+  }
+
+  namespace {
+    struct Primitive {
+      std::string_view name;
+      usize            size;
+    };
+
+    // naturally aligned, so size doubles as alignment.
+    constexpr Primitive primitives[] = {
+      { "u8", 1 }, { "i8", 1 }, { "bool", 1 },
+      { "u16", 2 }, { "i16", 2 },
+      { "u32", 4 }, { "i32", 4 }, { "f32", 4 },
+      { "u64", 8 }, { "i64", 8 }, { "f64", 8 },
+      { "usize", 8 }, { "size", 8 },
+    };
+
+    constexpr usize pointer_size = 8;
+
+    usize layoutAlignUp(usize offset, usize align) {
+      return (offset + align - 1) / align * align;
+    }
+  } // anonymous
+
+  Layouter::Layouter(std::vector<ast::StructExpression> &structures, bool split_cold):
+    split_cold(split_cold) {
+    for(ast::StructExpression &structure: structures)
+      declared[structure.getName()] = &structure;
+    for(const ast::StructExpression &structure: structures)
+      before.push_back(layoutOf(structure.getName()));
+
+    // splitting changes what a struct holds and so its alignment, every
+    // struct is rewritten after the ones it holds by value.
+    computed.clear();
+    for(ast::StructExpression &structure: structures) layoutRewrite(structure);
+
+    for(ast::StructExpression &structure: cold_parts)
+      structures.push_back(std::move(structure));
+    computed.clear();
+    for(ast::StructExpression &structure: structures)
+      declared[structure.getName()] = &structure;
+
+    for(const ast::StructExpression &structure: structures) {
+      StructLayout layout = layoutOf(structure.getName());
+      for(const FieldLayout &field: layout.fields)
+        if(field.type.starts_with('*') && field.name == "cold") layout.cold = field.type.substr(1);
+      if(auto lost = hot_losses.find(layout.name); lost != hot_losses.end()) 
+        layout.hot_loss = lost->second;
+      if(auto split = split_sizes.find(layout.name); split != split_sizes.end()) 
+        layout.split_size = split->second;
+      after.push_back(layout);
+    }
+  }
+
+  void Layouter::layoutRewrite(ast::StructExpression &structure) {
+    if(!rewritten.insert(structure.getName()).second) return;
+    for(const ast::Field &field: structure.getFields())
+      if(auto nested = declared.find(field.type); nested != declared.end())
+        layoutRewrite(*nested->second);
+    if(structure.isLayoutFixed()) return;
+
+    const std::string &name = structure.getName();
+    std::vector<ast::Field> hot, cold;
+    for(const ast::Field &field: structure.getFields())
+      (field.access == ast::Field::Access::cold ? cold : hot).push_back(field);
+
+    std::vector<ast::Field> ordered = layoutOptimize(structure.getFields(), split_cold);
+    if(split_cold && !cold.empty() && !hot.empty()) {
+      // the pointer has to save more than it costs, a split that doesn't
+      // shrink the struct only adds an indirection.
+      const std::string cold_name = std::format("{}.cold", name);
+      hot.push_back({ .name = "cold", .type = "*" + cold_name, .access = ast::Field::Access::unknown });
+      std::vector<ast::Field> split = layoutOptimize(hot, true);
+
+      const usize split_size = layoutFields(name, split).size;
+      if(split_size < layoutFields(name, ordered).size) {
+        cold_parts.push_back(ast::StructExpression(cold_name, layoutOptimize(cold, false), 
+              false, false));
+        ordered = std::move(split);
+      } else split_sizes[name] = split_size;
+    }
+
+    if(split_cold) {
+      const usize packed = layoutFields(name, layoutOptimize(structure.getFields(), false)).size;
+      const usize size = layoutFields(name, ordered).size;
+      if(size > packed) hot_losses[name] = size - packed;
+    }
+    structure.setFields(std::move(ordered));
+  }
+
+  const StructLayout &Layouter::layoutOf(const std::string &name) {
+    auto found = computed.find(name);
+    if(found != computed.end()) return found->second;
+
+    if(std::find(in_progress.begin(), in_progress.end(), name) != in_progress.end())
+      throw LayoutException(std::format("Struct {} contains itself.", name));
+
+    in_progress.push_back(name);
+    StructLayout layout = layoutFields(name, declared.at(name)->getFields());
+    in_progress.pop_back();
+
+    return computed.emplace(name, std::move(layout)).first->second;
+  }
+
+  void Layouter::layoutType(const std::string &type, usize &size, usize &align) {
+    if(type.starts_with('*')) {
+      size = align = pointer_size;
+      return;
+    }
+
+    for(const Primitive &primitive: primitives) {
+      if(primitive.name == type) {
+        size = align = primitive.size;
+        return;
+      }
+    }
+
+    if(!declared.contains(type))
+      throw LayoutException(std::format("Unknown type {}.", type));
+    const StructLayout &nested = layoutOf(type);
+    size = nested.size;
+    align = nested.align;
+  }
+
+  StructLayout Layouter::layoutFields(const std::string &name, 
+      const std::vector<ast::Field> &fields) {
+    StructLayout layout{ .name = name, .size = 0, .align = 1, .padding = 0 };
+    usize used = 0;
+
+    for(const ast::Field &field: fields) {
+      FieldLayout placed{ .name = field.name, .type = field.type };
+      layoutType(field.type, placed.size, placed.align);
+      placed.offset = layoutAlignUp(layout.size, placed.align);
+
+      layout.size = placed.offset + placed.size;
+      layout.align = std::max(layout.align, placed.align);
+      used += placed.size;
+      layout.fields.push_back(placed);
+    }
+
+    layout.size = layoutAlignUp(layout.size, layout.align);
+    layout.padding = layout.size - used;
+    return layout;
+  }
+
+  // with power of two alignments, decreasing alignment leaves no holes
+  // between fields, only tail padding. stable so equal fields keep 
+  // their declared order. hot_first puts $hot fields first, sorted
+  // among themselves, and fills the hole they leave before the rest 
+  // with the most aligned of the rest that fit in it.
+  std::vector<ast::Field> Layouter::layoutOptimize(std::vector<ast::Field> fields, 
+      bool hot_first) {
+    struct Sized {
+      usize      size;
+      usize      align;
+      ast::Field field;
+    };
+
+    std::vector<Sized> hot, rest;
+    for(ast::Field &field: fields) {
+      Sized sized{ .field = std::move(field) };
+      layoutType(sized.field.type, sized.size, sized.align);
+      (hot_first && sized.field.access == ast::Field::Access::hot ? hot : rest)
+        .push_back(std::move(sized));
+    }
+
+    auto byAlign = [](const Sized &a, const Sized &b) { return a.align > b.align; };
+    std::stable_sort(hot.begin(), hot.end(), byAlign);
+    std::stable_sort(rest.begin(), rest.end(), byAlign);
+
+    std::vector<ast::Field> ordered;
+    usize end = 0;
+    for(Sized &sized: hot) {
+      end = layoutAlignUp(end, sized.align) + sized.size;
+      ordered.push_back(std::move(sized.field));
+    }
+
+    if(!hot.empty() && !rest.empty()) {
+      // the first of the rest is the most aligned, the hole runs up to
+      // it. filled from the top so every field ends where the one after
+      // it starts.
+      std::vector<Sized> fill;
+      usize top = layoutAlignUp(end, rest.front().align);
+      for(auto it = rest.begin(); it != rest.end();) {
+        if(top < end + it->size || (top - it->size) % it->align != 0) {
+          it++;
+          continue;
+        }
+        top -= it->size;
+        fill.insert(fill.begin(), std::move(*it));
+        it = rest.erase(it);
+      }
+      for(Sized &sized: fill) ordered.push_back(std::move(sized.field));
+    }
+
+    for(Sized &sized: rest) ordered.push_back(std::move(sized.field));
+    return ordered;
+  }
+
+  const std::vector<StructLayout> &Layouter::getBefore() {
+    return before;
+  }
+
+  const std::vector<StructLayout> &Layouter::getAfter() {
+    return after;
+  }
+
+  void Layouter::print(std::ostream &output) {
+    auto printLayout = [&](const char *when, const StructLayout &layout) {
+      output << std::format("  {}: size {}, align {}, padding {}\n", 
+          when, layout.size, layout.align, layout.padding);
+      for(const FieldLayout &field: layout.fields)
+        output << std::format("    {:>4} {}: {}\n", field.offset, field.name, field.type);
+    };
+
+    for(const StructLayout &layout: after) {
+      output << std::format("struct {}\n", layout.name);
+      auto old = std::find_if(before.begin(), before.end(), 
+          [&](const StructLayout &b) { return b.name == layout.name; });
+      if(old != before.end()) printLayout("before", *old);
+      printLayout("after", layout);
+      if(!layout.cold.empty()) output << std::format("  cold fields in {}\n", layout.cold);
+      if(layout.split_size) 
+        output << std::format("  cold fields kept, split it would be {} bytes\n", layout.split_size);
+      if(layout.hot_loss) 
+        output << std::format("  $hot first costs {} bytes over ordering by alignment\n", 
+            layout.hot_loss);
+    }
+  }
+
+} // nukac::layout
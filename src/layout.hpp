@@ -0,0 +1,81 @@
+#ifndef NUKAC_LAYOUT_HPP
+#define NUKAC_LAYOUT_HPP
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "helper.hpp"
+#include "parser.hpp"
+
+namespace nukac::layout {
+  class LayoutException {
+    public:
+      LayoutException(std::string what);
+      const char *what();
+    private:
+      std::string what_did_i_do;
+  }; // LayoutException
+
+  struct FieldLayout {
+    std::string name;
+    std::string type;
+    usize       size;
+    usize       align;
+    usize       offset;
+  };
+
+  struct StructLayout {
+    std::string              name;
+    std::vector<FieldLayout> fields;
+    usize                    size;
+    usize                    align;
+    usize                    padding;
+    std::string              cold; // split off $cold part, empty if none
+
+    // what split_cold cost, for --print-layouts.
+    usize                    hot_loss = 0;   // bytes over ordering by alignment alone
+    usize                    split_size = 0; // size split, when that wasn't smaller
+  };
+
+  class Layouter {
+    public:
+      // reorders the fields of every struct that isn't pub or $abi to
+      // minimize padding, split_cold additionally puts $hot fields first
+      // and moves $cold fields behind a pointer into a "<name>.cold" 
+      // struct, when that makes the struct smaller.
+      Layouter(std::vector<parser::ast::StructExpression> &structures, bool split_cold);
+
+      const std::vector<StructLayout> &getBefore();
+      const std::vector<StructLayout> &getAfter();
+
+      // --print-layouts
+      void print(std::ostream &output);
+
+    private:
+      std::unordered_map<std::string, parser::ast::StructExpression *> declared;
+      std::unordered_map<std::string, StructLayout> computed;
+      std::vector<std::string> in_progress;
+      std::unordered_set<std::string> rewritten;
+      std::vector<parser::ast::StructExpression> cold_parts;
+      std::unordered_map<std::string, usize> hot_losses;
+      std::unordered_map<std::string, usize> split_sizes;
+      bool split_cold;
+
+      std::vector<StructLayout> before;
+      std::vector<StructLayout> after;
+
+      const StructLayout &layoutOf(const std::string &name);
+      void layoutType(const std::string &type, usize &size, usize &align);
+      StructLayout layoutFields(const std::string &name, 
+          const std::vector<parser::ast::Field> &fields);
+      void layoutRewrite(parser::ast::StructExpression &structure);
+      std::vector<parser::ast::Field> layoutOptimize(std::vector<parser::ast::Field> fields,
+          bool hot_first);
+  }; // Layouter
+
+} // nukac::layout
+
+#endif // NUKAC_LAYOUT_HPP
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <array>
 #include <format>
 #include <iostream>
+#include <iterator>
+#include <string_view>
 
 #include "lexer.hpp"
+#include "unicode.hpp"
 
 namespace nukac::lexer {
   LexerException::LexerException(std::string what) {
@@ -16,155 +21,362 @@ namespace nukac::lexer {
     return what_did_i_do.c_str();
   }
 
-#define LEXER_PUSH_BACK() \
-    if(after_star) continue; \
-    if(!reconstructed_string_literal.empty()){ \
-      literals.push_back({.where_character = token_at, .where_line = line_at, .literal_token = Token::string, .literal_string = reconstructed_string_literal}); \
-      literals.clear(); \
-    } \
-    if(after_slash) { literals.push_back({ .where_character = token_at - 1, .where_line = line_at, .literal_token = Token::slash }); after_slash = false; } \
-    if(after_dash) { literals.push_back({ .where_character = token_at - 1, .where_line = line_at, .literal_token = Token::dash }); after_dash = false; } \
-    if(after_backslash) { after_backslash = false; } \
+  namespace {
+    enum class CharClass: u8 {
+      invalid,
+      blank,
+      newline,
+      word,
+      single,
+      slash,
+      star,
+      dash,
+      greater,
+      dquote,
+      backslash,
+      utf8,
 
-#define LEXER_SWITCH(token) \
-    LEXER_PUSH_BACK(); \
-    literals.push_back({ .where_character = token_at, .where_line = line_at, .literal_token = token }); \
-    continue; 
+      count,
+    }; // CharClass
+
+    enum class State: u8 {
+      start,
+      word,
+      slash,
+      dash,
+      line_comment,
+      block_comment,
+      block_star,
+      string,
+      string_escape,
+
+      count,
+    }; // State
+
+    enum class Action: u8 {
+      none,
+      single,
+      word_begin,
+      word_flush,   // emits the word and retries the byte from State::start
+      lead_flush,   // same for a lone '/' or '-'
+      utf8_word_begin,
+      utf8_word,
+      arrow,
+      line_comment, // skips to the newline, which ends it
+      string_begin,
+      string_append,
+      string_escape,
+      string_end,
+      invalid,
+    }; // Action
+
+    struct Transition {
+      Action action;
+      State  next;
+    };
+
+    struct SingleToken {
+      char  c;
+      Token token;
+    };
+
+    struct ClassSpec {
+      std::string_view chars;
+      CharClass        char_class;
+    };
+
+    struct EscapeSpec {
+      char escaped;
+      char replacement;
+    };
+
+    // the token specification, tables below are generated from it.
+    constexpr SingleToken single_tokens[] = {
+      { '!', Token::exclamation },
+      { '?', Token::question },
+      { '|', Token::pipe },
+      { '&', Token::ampersand },
+      { '$', Token::dollar },
+      { '%', Token::percent },
+      { '/', Token::slash },
+      { '*', Token::star },
+      { '+', Token::plus },
+      { '-', Token::dash },
+      { '=', Token::equals },
+      { '\\', Token::backslash },
+      { '.', Token::dot },
+      { ',', Token::comma },
+      { ':', Token::colon },
+      { '(', Token::lparen },
+      { ')', Token::rparen },
+      { '[', Token::lsqbrace },
+      { ']', Token::rsqbrace },
+      { '{', Token::lcrbrace },
+      { '}', Token::rcrbrace },
+      { '\'', Token::squote },
+      { '<', Token::left_inequality },
+      { '>', Token::right_inequality },
+      { ';', Token::semicolon },
+    };
+
+    // every single token is CharClass::single unless listed here, later 
+    // entries win, so the multi-char leads override it.
+    constexpr ClassSpec char_classes[] = {
+      { " \t\r\v\f", CharClass::blank },
+      { "\n", CharClass::newline },
+      { "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_", CharClass::word },
+      { "/", CharClass::slash },
+      { "*", CharClass::star },
+      { "-", CharClass::dash },
+      { ">", CharClass::greater },
+      { "\"", CharClass::dquote },
+      { "\\", CharClass::backslash },
+    };
+
+    constexpr EscapeSpec escapes[] = {
+      { 'n', '\n' },
+      { 't', '\t' },
+      { 'r', '\r' },
+      { '0', '\0' },
+    };
+
+    constexpr usize class_count = static_cast<usize>(CharClass::count);
+    constexpr usize state_count = static_cast<usize>(State::count);
+
+    template <auto &singles, auto &spec>
+    consteval std::array<CharClass, 256> lexerClassTable() {
+      std::array<CharClass, 256> table{};
+      // anything above ASCII was validated as UTF-8 before lexing starts.
+      for(usize c = 0; c < table.size(); c++) 
+        table[c] = c < 0x80 ? CharClass::invalid : CharClass::utf8;
+      for(const SingleToken &s: singles) table[static_cast<u8>(s.c)] = CharClass::single;
+      for(const ClassSpec &s: spec)
+        for(char c: s.chars) table[static_cast<u8>(c)] = s.char_class;
+      return table;
+    }
+
+    template <auto &spec>
+    consteval std::array<Token, 256> lexerTokenTable() {
+      std::array<Token, 256> table{};
+      for(const SingleToken &s: spec) table[static_cast<u8>(s.c)] = s.token;
+      return table;
+    }
+
+    template <auto &spec>
+    consteval std::array<char, 256> lexerEscapeTable() {
+      std::array<char, 256> table{};
+      for(usize c = 0; c < table.size(); c++) table[c] = static_cast<char>(c);
+      for(const EscapeSpec &s: spec) table[static_cast<u8>(s.escaped)] = s.replacement;
+      return table;
+    }
+
+    consteval std::array<std::array<Transition, class_count>, state_count> lexerTransitions() {
+      std::array<std::array<Transition, class_count>, state_count> table{};
+      auto every = [&](State s, Action a, State n) {
+        for(Transition &t: table[static_cast<usize>(s)]) t = { a, n };
+      };
+      auto on = [&](State s, CharClass c, Action a, State n) {
+        table[static_cast<usize>(s)][static_cast<usize>(c)] = { a, n };
+      };
+
+      every(State::start, Action::single, State::start);
+      on(State::start, CharClass::invalid, Action::invalid, State::start);
+      on(State::start, CharClass::blank, Action::none, State::start);
+      on(State::start, CharClass::newline, Action::none, State::start);
+      on(State::start, CharClass::word, Action::word_begin, State::word);
+      on(State::start, CharClass::slash, Action::none, State::slash);
+      on(State::start, CharClass::dash, Action::none, State::dash);
+      on(State::start, CharClass::dquote, Action::string_begin, State::string);
+      on(State::start, CharClass::utf8, Action::utf8_word_begin, State::word);
+
+      every(State::word, Action::word_flush, State::start);
+      on(State::word, CharClass::word, Action::none, State::word);
+      on(State::word, CharClass::utf8, Action::utf8_word, State::word);
+
+      every(State::slash, Action::lead_flush, State::start);
+      on(State::slash, CharClass::slash, Action::line_comment, State::line_comment);
+      on(State::slash, CharClass::star, Action::none, State::block_comment);
+
+      every(State::dash, Action::lead_flush, State::start);
+      on(State::dash, CharClass::greater, Action::arrow, State::start);
+
+      every(State::line_comment, Action::none, State::line_comment);
+      on(State::line_comment, CharClass::newline, Action::none, State::start);
+
+      every(State::block_comment, Action::none, State::block_comment);
+      on(State::block_comment, CharClass::star, Action::none, State::block_star);
+
+      every(State::block_star, Action::none, State::block_comment);
+      on(State::block_star, CharClass::star, Action::none, State::block_star);
+      on(State::block_star, CharClass::slash, Action::none, State::start);
+
+      every(State::string, Action::string_append, State::string);
+      on(State::string, CharClass::dquote, Action::string_end, State::start);
+      on(State::string, CharClass::backslash, Action::none, State::string_escape);
+
+      every(State::string_escape, Action::string_escape, State::string);
+      return table;
+    }
+
+    constexpr auto class_table = lexerClassTable<single_tokens, char_classes>();
+    constexpr auto token_table = lexerTokenTable<single_tokens>();
+    constexpr auto escape_table = lexerEscapeTable<escapes>();
+    // the class lookup folded into the transitions, one load per byte.
+    template <auto &classes, auto &by_class>
+    consteval std::array<std::array<Transition, 256>, state_count> lexerByteTransitions() {
+      std::array<std::array<Transition, 256>, state_count> table{};
+      for(usize s = 0; s < state_count; s++)
+        for(usize c = 0; c < 256; c++) table[s][c] = by_class[s][static_cast<usize>(classes[c])];
+      return table;
+    }
+
+    constexpr auto class_transitions = lexerTransitions();
+    constexpr auto transitions = lexerByteTransitions<class_table, class_transitions>();
+  } // anonymous
 
   Lexer::Lexer(std::istream &is): is(is) {
-    std::string reconstructed_string_literal;
-    std::string line;
+    const std::string source{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+    if(usize bad; !unicode::validUtf8(source, bad)) {
+      const usize newline = bad == 0 ? std::string::npos : source.rfind('\n', bad - 1);
+      const usize line_begin = newline == std::string::npos ? 0 : newline + 1;
+      const usize line = std::count(source.begin(), source.begin() + bad, '\n') + 1;
+      // columns count codepoints, same as for tokens.
+      const usize column = std::count_if(source.begin() + line_begin, source.begin() + bad, 
+          [](char c) { return (static_cast<u8>(c) & 0xC0) != 0x80; }) + 1;
+      throw LexerException("Invalid UTF-8.", column, line);
+    }
+
     literals_vector_at = 0;
     token_at = 0;
-    line_at = 0;
-
-    bool after_star_comment = false;
-    while(std::getline(is, line)) {
-      for(char c: line) {
-        bool after_star = false;
-        bool after_slash = false;
-        bool after_backslash = false;
-        bool after_dash = false;
-        bool string_literal = false;
-        token_at++;
-        switch (c) {
-          case '/': LEXER_PUSH_BACK();
-                    if(after_slash) {
-                      after_slash = false;
-                      break;
-                    } else if(after_star) {
-                      after_star = false;
-                      continue;
-                    } else {
-                      after_slash = true;
-                      continue;
-                    }
-
-          case '*': if (after_slash) {
-                      after_slash = false;
-                      after_star_comment = true;
-                      continue;
-                    } else if (after_star_comment) {
-                      after_star = true;
-                      continue;
-                    } else {
-                      LEXER_SWITCH(Token::star);
-                      continue;
-                    }
-
-          case '>': LEXER_PUSH_BACK() 
-                    if(after_dash == true) {
-                      LEXER_SWITCH(Token::arrow);
-                      after_dash = false;
-                    } else LEXER_SWITCH(Token::right_inequality);
-                    continue;
-
-          case '!': LEXER_SWITCH(Token::exclamation); 
-          case '?': LEXER_SWITCH(Token::question);
-          case '|': LEXER_SWITCH(Token::pipe); 
-          case '&': LEXER_SWITCH(Token::ampersand); 
-          case '$': LEXER_SWITCH(Token::dollar);
-          case '%': LEXER_SWITCH(Token::percent); 
-          case '+': LEXER_SWITCH(Token::plus);
-          case '-': after_dash = true; continue;
-          case '=': LEXER_SWITCH(Token::equals);
-          case '\\': after_backslash = true; continue;
-          case '.': LEXER_SWITCH(Token::dot); 
-          case ',': LEXER_SWITCH(Token::comma); 
-          case ':': LEXER_SWITCH(Token::comma)
-          case '(': LEXER_SWITCH(Token::lparen); 
-          case ')': LEXER_SWITCH(Token::rparen);
-          case '[': LEXER_SWITCH(Token::lsqbrace); 
-          case ']': LEXER_SWITCH(Token::rsqbrace); 
-          case '{': LEXER_SWITCH(Token::lcrbrace); 
-          case '}': LEXER_SWITCH(Token::rcrbrace); 
-          case '"': LEXER_PUSH_BACK();
-                    if(!string_literal) string_literal = true;
-                    else if(string_literal && !after_slash) { 
-                      string_literal = false;
-                      literals.push_back({
-                          .where_character = token_at,
-                          .where_line = line_at,
-                          .literal_token = Token::quoted,
-                          .literal_string = reconstructed_string_literal
-                      });
-                    }
-                    else if(string_literal && after_slash) {
-                      after_slash = false;
-                      string_literal = false;
-                      reconstructed_string_literal.push_back(c);
-                    }
-                    continue;
-          case '\'':  LEXER_SWITCH(Token::backslash); 
-          case '<': LEXER_SWITCH(Token::left_inequality); 
-          case ' ': case '\t':
-                    token_at++; continue;
-          case ';': LEXER_SWITCH(Token::semicolon);
-          case '\n': line_at++; token_at = 0; continue;
-          
-          case 'a': case 'A':
-          case 'b': case 'B':
-          case 'c': case 'C':
-          case 'd': case 'D':
-          case 'e': case 'E':
-          case 'f': case 'F':
-          case 'g': case 'G':
-          case 'h': case 'H':
-          case 'i': case 'I':
-          case 'j': case 'J':
-          case 'k': case 'K':
-          case 'l': case 'L':
-          case 'm': case 'M':
-          case 'n': case 'N':
-          case 'o': case 'O':
-          case 'p': case 'P':
-          case 'r': case 'R':
-          case 's': case 'S':
-          case 't': case 'T':
-          case 'u': case 'U':
-          case 'v': case 'V':
-          case 'w': case 'W':
-          case 'x': case 'X':
-          case 'y': case 'Y':
-          case 'z': case 'Z':
-          reconstructed_string_literal.push_back(c); continue;
-          
-          default: throw LexerException(std::format("Invalid character {}", c), token_at, line_at);
+    line_at = 1;
+
+    State state = State::start;
+    usize word_begin = 0;
+    usize begin_character = 0;
+    usize begin_line = 0;
+    std::string quoted;
+
+    // about one token per three bytes in typical sources, growing the
+    // vector used to cost more than lexing.
+    literals.reserve(source.size() / 3 + 1);
+    // built in place, a word is copied once, straight out of the source.
+    auto push = [&](Token token, usize character, usize line, std::string_view s) {
+      Literal &literal = literals.emplace_back();
+      literal.where_character = character;
+      literal.where_line = line;
+      literal.literal_token = token;
+      literal.literal_string.assign(s);
+    };
+    const std::string_view view = source;
+
+    for(usize i = 0; i < source.size();) {
+      const u8 c = source[i];
+      usize step = 1;
+      const Transition t = transitions[static_cast<usize>(state)][c];
+      state = t.next;
+
+      switch(t.action) {
+        case Action::none: break;
+        case Action::single: push(token_table[c], token_at + 1, line_at, {}); break;
+        case Action::word_begin: {
+          word_begin = i;
+          begin_character = token_at + 1;
+          begin_line = line_at;
+          // the ASCII tail of a word stays in State::word, run it here 
+          // instead of once per byte through the transitions.
+          usize end = i + 1;
+          while(end < source.size() && class_table[static_cast<u8>(source[end])] == CharClass::word) end++;
+          token_at += end - i - 1;
+          step = end - i;
+          // and flush it right away unless a non-ASCII part follows.
+          if(end == source.size() || class_table[static_cast<u8>(source[end])] != CharClass::utf8) {
+            push(Token::string, begin_character, begin_line, view.substr(word_begin, end - word_begin));
+            state = State::start;
+          }
+          break;
         }
+        case Action::word_flush:
+          push(Token::string, begin_character, begin_line, view.substr(word_begin, i - word_begin));
+          continue;
+        case Action::lead_flush:
+          push(token_table[static_cast<u8>(source[i - 1])], token_at, line_at, {});
+          continue;
+        case Action::utf8_word_begin: {
+          usize end = i;
+          const u32 codepoint = unicode::decode(source, end);
+          if(!unicode::isXidStart(codepoint))
+            throw LexerException(std::format("Invalid character U+{:04X}", codepoint), token_at + 1, line_at);
+          word_begin = i;
+          begin_character = token_at + 1;
+          begin_line = line_at;
+          step = end - i;
+          break;
+        }
+        case Action::utf8_word: {
+          usize end = i;
+          if(!unicode::isXidContinue(unicode::decode(source, end))) {
+            push(Token::string, begin_character, begin_line, view.substr(word_begin, i - word_begin));
+            state = State::start;
+            continue;
+          }
+          step = end - i;
+          break;
+        }
+        case Action::arrow: push(Token::arrow, token_at, line_at, {}); break;
+        case Action::line_comment: {
+          // the newline resets the column, the skipped bytes don't count.
+          const usize newline = source.find('\n', i);
+          step = (newline == std::string::npos ? source.size() : newline) - i;
+          break;
+        }
+        case Action::string_begin:
+          quoted.clear();
+          begin_character = token_at + 1;
+          begin_line = line_at;
+          break;
+        case Action::string_append: quoted.push_back(c); break;
+        case Action::string_escape: quoted.push_back(escape_table[c]); break;
+        case Action::string_end: push(Token::quoted, begin_character, begin_line, quoted); break;
+        case Action::invalid: 
+          throw LexerException(std::format("Invalid character {}", static_cast<char>(c)), token_at + 1, line_at);
       }
+
+      // columns count codepoints, continuation bytes don't move them.
+      if(c == '\n') {
+        line_at++;
+        token_at = 0;
+      } else if((c & 0xC0) != 0x80) token_at++;
+      i += step;
+    }
+
+    switch(state) {
+      case State::word:
+        push(Token::string, begin_character, begin_line, view.substr(word_begin));
+        break;
+      case State::slash: push(Token::slash, token_at, line_at, {}); break;
+      case State::dash: push(Token::dash, token_at, line_at, {}); break;
+      case State::string: case State::string_escape:
+        throw LexerException("Unterminated string literal.", begin_character, begin_line);
+      case State::block_comment: case State::block_star:
+        throw LexerException("Unterminated comment.", token_at, line_at);
+      default: break;
     }
   }
 
   Literal Lexer::next(){
-    return literals[literals_vector_at + 1];  
+    if(isEoC()) {
+      const Literal &l = literals.empty() ? Literal{} : literals.back();
+      throw LexerException("Unexpected end of file.", l.where_character, l.where_line);
+    }
+    return literals[literals_vector_at];
   }
 
   bool Lexer::next(Token w){
-    return (w == literals[literals_vector_at + 1].literal_token);
+    return !isEoC() && w == literals[literals_vector_at].literal_token;
   }
   
   bool Lexer::next(std::string w){
-    return (literals[literals_vector_at + 1].isString() && w == literals[literals_vector_at + 1].literal_string);
+    return !isEoC() && literals[literals_vector_at].isString() && w == literals[literals_vector_at].literal_string;
   }
     
   Literal Lexer::swallow(){
@@ -190,11 +402,50 @@ namespace nukac::lexer {
     literals_vector_at++;
   }
 
+  usize Lexer::skipBalanced(Token open, Token close) {
+    if(!next(open)) {
+      Literal l = next();
+      throw LexerException("Expected an opening bracket.", l.where_character, l.where_line);
+    }
+
+    usize depth = 0;
+    for(usize i = literals_vector_at; i < literals.size(); i++) {
+      const Token t = literals[i].literal_token;
+      if(t == open) depth++;
+      else if(t == close && --depth == 0) {
+        literals_vector_at = i + 1;
+        return i;
+      }
+    }
+
+    Literal l = next();
+    throw LexerException("Unbalanced bracket.", l.where_character, l.where_line);
+  }
+
+  usize Lexer::position() {
+    return literals_vector_at;
+  }
+
+  void Lexer::seek(usize at) {
+    literals_vector_at = at;
+  }
+
   bool Lexer::isEoC() {
-    if(literals_vector_at == literals.size()) return true;
+    if(literals_vector_at >= literals.size()) return true;
     else return false;
   }
 
+  std::ostream &operator<<(std::ostream &output, Literal &literal) {
+    output << std::format("{}:{}: ", literal.where_line, literal.where_character);
+    if(literal.isString()) return output << literal.literal_string;
+    if(literal.isQuoted()) return output << '"' << literal.literal_string << '"';
+    if(literal.literal_token == Token::arrow) return output << "->";
+
+    for(const SingleToken &single: single_tokens)
+      if(single.token == literal.literal_token) return output << single.c;
+    return output;
+  }
+
 
   bool operator==(const std::string &s, Literal &l) noexcept {
     return (l.isString() && s == l.literal_string); 
@@ -64,6 +64,8 @@ namespace nukac::lexer {
   };
 
   std::ostream &operator<<(std::ostream &output, Literal &literal);
+  bool operator==(const std::string &s, Literal &l) noexcept;
+  bool operator==(const Token &t, Literal &l) noexcept;
 
   class Lexer {
     public:
@@ -78,6 +80,12 @@ namespace nukac::lexer {
       bool swallow(std::string w);
       void swallowZ();
 
+      // skips a balanced open...close run starting at next(), leaving the
+      // closing token swallowed. returns where the closing token is.
+      usize skipBalanced(Token open, Token close);
+      usize position();
+      void seek(usize at);
+
       bool isEoC();
 
     private:
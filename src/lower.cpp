@@ -0,0 +1,185 @@
+#include <format>
+#include <unordered_set>
+
+#include "lower.hpp"
+
+namespace nukac::lower {
+  using namespace nukac::parser;
+
+  LowerException::LowerException(std::string what) {
+    what_did_i_do = what;
+  }
+
+  const char *LowerException::what() {
+    return what_did_i_do.c_str();
+  }
+
+  std::ostream &operator<<(std::ostream &output, const Instruction &instruction) {
+    switch(instruction.op) {
+      case Instruction::Op::eval: output << "eval"; break;
+      case Instruction::Op::eval_try: output << "eval_try"; break;
+      case Instruction::Op::eval_result: output << "eval_result"; break;
+      case Instruction::Op::branch_ok: output << std::format("branch_ok L{}", instruction.target); break;
+      case Instruction::Op::return_ok: output << "return_ok"; break;
+      case Instruction::Op::return_error:
+        if(instruction.propagate) output << "return_error propagate";
+        else output << std::format("return_error {}", instruction.error_tag);
+        break;
+      case Instruction::Op::label: output << std::format("L{}:", instruction.target); break;
+    }
+    return output;
+  }
+
+  std::vector<ast::Field> errorUnionFields(const std::string &payload) {
+    std::vector<ast::Field> fields = {
+      { .name = "tag", .type = "u16", .access = ast::Field::Access::hot },
+    };
+    if(payload != "void")
+      fields.push_back({ .name = "value", .type = payload, .access = ast::Field::Access::unknown });
+    return fields;
+  }
+
+  std::vector<ast::StructExpression> errorUnions(const std::vector<ast::Prototype> &prototypes) {
+    std::vector<ast::StructExpression> unions;
+    std::unordered_set<std::string> seen;
+    for(const ast::Prototype &proto: prototypes) {
+      // a generic's payload is only known per instance.
+      if(!proto.canFail() || proto.isGeneric()) continue;
+      const std::string &payload = proto.getReturnType().getName();
+      const std::string name = std::format("{}!{}", proto.getErrorSet(), payload);
+      if(seen.insert(name).second)
+        unions.push_back(ast::StructExpression(name, errorUnionFields(payload), false, false));
+    }
+    return unions;
+  }
+
+  std::vector<Statement> statementsOf(const std::vector<ast::ExpressionPtr> &body) {
+    std::vector<Statement> statements;
+    for(const ast::ExpressionPtr &expression: body) {
+      if(auto deferred = std::dynamic_pointer_cast<ast::DeferExpression>(expression)) {
+        statements.push_back({ 
+            .kind = deferred->onError() ? Statement::Kind::errdefer : Statement::Kind::defer,
+            .body = statementsOf(deferred->getBody())
+        });
+      } else if(auto block = std::dynamic_pointer_cast<ast::BlockExpression>(expression)) {
+        statements.push_back({ .kind = Statement::Kind::block, .body = statementsOf(block->getBody()) });
+      } else if(auto ret = std::dynamic_pointer_cast<ast::ReturnExpression>(expression)) {
+        if(auto error = std::dynamic_pointer_cast<ast::ErrorExpression>(ret->getValue()))
+          statements.push_back({ 
+              .kind = Statement::Kind::return_error, 
+              .error_tag = ast::errorTag(error->getError()) 
+          });
+        else statements.push_back({ .kind = Statement::Kind::return_ok, .expression = ret->getValue().get() });
+      } else {
+        ast::ExpressionPtr value = expression;
+        if(auto variable = std::dynamic_pointer_cast<ast::VariableExpression>(expression))
+          value = variable->getStored();
+        else if(auto assign = std::dynamic_pointer_cast<ast::AssignExpression>(expression))
+          value = assign->getValue();
+
+        const bool tried = std::dynamic_pointer_cast<ast::TryExpression>(value) != nullptr;
+        statements.push_back({ 
+            .kind = tried ? Statement::Kind::try_call : Statement::Kind::expression, 
+            .expression = expression.get() 
+        });
+      }
+    }
+    return statements;
+  }
+
+  Lowerer::Lowerer(const std::vector<Statement> &body) {
+    lowerBlock(body);
+    
+    if(instructions.empty() || (instructions.back().op != Instruction::Op::return_ok &&
+          instructions.back().op != Instruction::Op::return_error))
+      instructions.push_back({ .op = Instruction::Op::return_ok });
+  }
+
+  void Lowerer::lowerBlock(const std::vector<Statement> &body) {
+    scopes.emplace_back();
+    for(const Statement &statement: body) lowerStatement(statement);
+
+    // falling off the end of a block is a success exit of that block only.
+    const bool returned = !instructions.empty() && 
+      (instructions.back().op == Instruction::Op::return_ok ||
+       instructions.back().op == Instruction::Op::return_error);
+    if(!returned) lowerCleanup(scopes.size() - 1, false);
+    scopes.pop_back();
+  }
+
+  void Lowerer::lowerStatement(const Statement &statement) {
+    switch(statement.kind) {
+      case Statement::Kind::expression:
+        instructions.push_back({ .op = Instruction::Op::eval, .expression = statement.expression });
+        break;
+
+      case Statement::Kind::block:
+        lowerBlock(statement.body);
+        break;
+
+      case Statement::Kind::defer:
+      case Statement::Kind::errdefer:
+        scopes.back().push_back(&statement);
+        break;
+
+      case Statement::Kind::try_call: {
+        const usize ok = labels++;
+        instructions.push_back({ .op = Instruction::Op::eval_try, .expression = statement.expression });
+        instructions.push_back({ .op = Instruction::Op::branch_ok, .target = ok });
+        lowerCleanup(0, true);
+        instructions.push_back({ .op = Instruction::Op::return_error, .propagate = true });
+        instructions.push_back({ .op = Instruction::Op::label, .target = ok });
+        break;
+      }
+
+      case Statement::Kind::return_ok:
+        // the value is computed before any defer can touch what it reads.
+        if(statement.expression)
+          instructions.push_back({ .op = Instruction::Op::eval_result, .expression = statement.expression });
+        lowerCleanup(0, false);
+        instructions.push_back({ .op = Instruction::Op::return_ok });
+        break;
+
+      case Statement::Kind::return_error:
+        lowerCleanup(0, true);
+        instructions.push_back({ 
+            .op = Instruction::Op::return_error, 
+            .error_tag = statement.error_tag 
+        });
+        break;
+    }
+  }
+
+  // innermost scope first, each in reverse declaration order.
+  void Lowerer::lowerCleanup(usize outermost, bool error) {
+    for(usize scope = scopes.size(); scope-- > outermost;) {
+      const std::vector<const Statement *> &deferred = scopes[scope];
+      for(auto statement = deferred.rbegin(); statement != deferred.rend(); statement++) {
+        if((*statement)->kind == Statement::Kind::errdefer && !error) continue;
+        lowerDeferred((*statement)->body);
+      }
+    }
+  }
+
+  // expanded in place, so its own scope stack must not see the
+  // deferring scopes again.
+  void Lowerer::lowerDeferred(const std::vector<Statement> &body) {
+    for(const Statement &statement: body) {
+      switch(statement.kind) {
+        case Statement::Kind::expression:
+          instructions.push_back({ .op = Instruction::Op::eval, .expression = statement.expression });
+          break;
+        case Statement::Kind::block:
+          lowerDeferred(statement.body);
+          break;
+        default:
+          throw LowerException("Only expressions can be deferred, no returns, try or nested defers.");
+      }
+    }
+  }
+
+  const std::vector<Instruction> &Lowerer::getInstructions() {
+    return instructions;
+  }
+
+} // nukac::lower
@@ -0,0 +1,94 @@
+#ifndef NUKAC_LOWER_HPP
+#define NUKAC_LOWER_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "helper.hpp"
+#include "parser.hpp"
+
+namespace nukac::lower {
+  class LowerException {
+    public:
+      LowerException(std::string what);
+      const char *what();
+    private:
+      std::string what_did_i_do;
+  }; // LowerException
+
+  // a function body as scopes of statements, expressions stay opaque.
+  struct Statement {
+    enum class Kind {
+      expression,
+      block,
+      defer,        // body runs at every exit of the enclosing block
+      errdefer,     // same, only on exits that return an error
+      try_call,     // expression yields an error union, propagates errors
+      return_ok,
+      return_error, // error_tag from ast::ErrorSet::tagOf, global
+    };
+
+    Kind                               kind;
+    const parser::ast::Expression     *expression;
+    u16                                error_tag;
+    std::vector<Statement>             body;
+  };
+
+  // flat, branch based code. an error union is { tag: u16, value: T },
+  // tag 0 being success, so nothing here unwinds or allocates.
+  struct Instruction {
+    enum class Op {
+      eval,
+      eval_try,     // evaluates into the error union slot
+      eval_result,  // evaluates the return value into the result slot
+      branch_ok,    // jumps to target if the slot's tag is 0
+      return_ok,    // returns the result slot
+      return_error, // returns error_tag, or the slot's tag if propagate
+      label,
+    };
+
+    Op                             op;
+    const parser::ast::Expression *expression;
+    u16                            error_tag;
+    bool                           propagate;
+    usize                          target;
+  };
+
+  std::ostream &operator<<(std::ostream &output, const Instruction &instruction);
+
+  // error unions are ordinary structs to the layout pass, Set!void is
+  // only the tag.
+  std::vector<parser::ast::Field> errorUnionFields(const std::string &payload);
+
+  // a "Set!T" struct per error union a non generic prototype returns.
+  std::vector<parser::ast::StructExpression> errorUnions(
+      const std::vector<parser::ast::Prototype> &prototypes);
+
+  // a parsed body as statements. try as a statement, initializer or 
+  // assigned value is a try_call of that statement, return Set.Error a
+  // return_error.
+  std::vector<Statement> statementsOf(const std::vector<parser::ast::ExpressionPtr> &body);
+
+  class Lowerer {
+    public:
+      // defer and errdefer bodies are copied to every exit they cover,
+      // the happy path only ever sees a tag compare per try.
+      Lowerer(const std::vector<Statement> &body);
+
+      const std::vector<Instruction> &getInstructions();
+
+    private:
+      std::vector<Instruction> instructions;
+      std::vector<std::vector<const Statement *>> scopes;
+      usize labels = 0;
+
+      void lowerBlock(const std::vector<Statement> &body);
+      void lowerStatement(const Statement &statement);
+      void lowerCleanup(usize outermost, bool error);
+      void lowerDeferred(const std::vector<Statement> &body);
+  }; // Lowerer
+
+} // nukac::lower
+
+#endif // NUKAC_LOWER_HPP
@@ -1,13 +1,91 @@
+#include <filesystem>
+#include <format>
 #include <fstream>
+#include <iostream>
+#include <string>
 
 #include "lexer.hpp"
 #include "helper.hpp"
+#include "layout.hpp"
+#include "lower.hpp"
+#include "mono.hpp"
+#include "parser.hpp"
+#include "sema.hpp"
 
 int main(int argc, char *argv[]){
+  std::string path;
+  bool report_instantiations = false;
+  bool lazy = false;
+  bool print_layouts = false;
+  bool split_cold = false;
+  bool print_lowered = false;
+
+  for(int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if(arg == "--report-instantiations") report_instantiations = true;
+    else if(arg == "--lazy") lazy = true;
+    else if(arg == "--print-layouts") print_layouts = true;
+    else if(arg == "--split-cold") split_cold = true;
+    else if(arg == "--print-lowered") print_lowered = true;
+    else path = arg;
+  }
+
+  std::ifstream ifs(path);
+  if(!ifs) {
+    nukac::helper::exceptionHandler(std::format("Can't open {}.", path));
+    return 1;
+  }
+
   try {
-    std::ifstream ifs(argv[0]);
     nukac::lexer::Lexer ll(ifs);
+    // a file is a module, ziglike, named after it.
+    nukac::parser::Parser pp(ll, lazy, std::filesystem::path(path).stem().string());
+    nukac::sema::Analyzer aa(pp);
+
+    for(const nukac::sema::Diagnostic &diagnostic: aa.getDiagnostics())
+      std::cout << path << ":" << diagnostic << "\n";
+
+    if(report_instantiations) nukac::mono::cache().report(std::cout);
+
+    // only checked bodies are lowered, lazily skipped ones aren't there.
+    if(!aa.hasErrors()) {
+      std::vector<nukac::parser::ast::Function> functions = pp.getFunctions();
+      for(const nukac::parser::ast::Implementation &implementation: pp.getImplementations())
+        functions.insert(functions.end(), implementation.getFunctions().begin(), 
+            implementation.getFunctions().end());
+
+      for(const nukac::parser::ast::Function &function: functions) {
+        if(!function.isParsed()) continue;
+        nukac::lower::Lowerer lowerer(nukac::lower::statementsOf(function.getBody()));
+        if(!print_lowered) continue;
+
+        std::cout << std::format("fn {}\n", function.getPrototype().getName());
+        for(const nukac::lower::Instruction &instruction: lowerer.getInstructions()) {
+          std::cout << "  " << instruction;
+          if(instruction.expression) 
+            std::cout << std::format(" @{}:{}", instruction.expression->where_line, 
+                instruction.expression->where_character);
+          std::cout << "\n";
+        }
+      }
+    }
+
+    if(print_layouts) {
+      std::vector<nukac::parser::ast::StructExpression> structures = pp.getStructures();
+      for(nukac::parser::ast::StructExpression &error_union: nukac::lower::errorUnions(pp.getPrototypes()))
+        structures.push_back(std::move(error_union));
+      nukac::layout::Layouter layouter(structures, split_cold);
+      layouter.print(std::cout);
+    }
+    return aa.hasErrors() ? 1 : 0;
   } catch (nukac::lexer::LexerException &e) {
     nukac::helper::exceptionHandler(e.what());
+  } catch (nukac::parser::ParserException &e) {
+    nukac::helper::exceptionHandler(e.what());
+  } catch (nukac::layout::LayoutException &e) {
+    nukac::helper::exceptionHandler(e.what());
+  } catch (nukac::lower::LowerException &e) {
+    nukac::helper::exceptionHandler(e.what());
   }
+  return 1;
 }
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <format>
+
+#include "mono.hpp"
+
+namespace nukac::mono {
+  TypeId TypeTable::intern(const std::string &name) {
+    {
+      std::shared_lock lock(mutex);
+      auto id = ids.find(name);
+      if(id != ids.end()) return id->second;
+    }
+
+    std::unique_lock lock(mutex);
+    auto [id, inserted] = ids.try_emplace(name, static_cast<TypeId>(names.size()));
+    if(inserted) names.push_back(name);
+    return id->second;
+  }
+
+  const std::string &TypeTable::name(TypeId id) {
+    std::shared_lock lock(mutex);
+    return names.at(id);
+  }
+
+  usize InstantiationKeyHash::operator()(const InstantiationKey &key) const noexcept {
+    usize hash = std::hash<std::string>{}(key.function);
+    for(TypeId id: key.arguments)
+      hash ^= std::hash<TypeId>{}(id) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash;
+  }
+
+  const Instance &InstantiationCache::instantiate(const std::string &function, 
+      std::vector<TypeId> arguments, std::function<void(const Instance &)> build) {
+    InstantiationKey key{ .function = function, .arguments = std::move(arguments) };
+
+    Entry *entry = nullptr;
+    {
+      std::shared_lock lock(mutex);
+      auto found = entries.find(key);
+      if(found != entries.end()) entry = found->second.get();
+    }
+
+    if(entry) {
+      hits++;
+    } else {
+      std::unique_lock lock(mutex);
+      auto [found, inserted] = entries.try_emplace(key, nullptr);
+      if(inserted) {
+        std::string mangled = function;
+        for(TypeId id: key.arguments) mangled += std::format("${}", types.name(id));
+
+        found->second = std::make_unique<Entry>();
+        found->second->instance = { .key = key, .mangled_name = std::move(mangled) };
+        instantiations++;
+
+        if(++per_function[function] == limit + 1)
+          helper::warningHandler(std::format("{} was instantiated more than {} times, "
+                "check for recursive generics.", function, limit));
+      } else hits++;
+      entry = found->second.get();
+    }
+
+    if(build) std::call_once(entry->built, build, std::cref(entry->instance));
+    return entry->instance;
+  }
+
+  void InstantiationCache::setLimit(usize limit) {
+    std::unique_lock lock(mutex);
+    this->limit = limit;
+  }
+
+  usize InstantiationCache::getInstantiations() {
+    return instantiations;
+  }
+
+  usize InstantiationCache::getHits() {
+    return hits;
+  }
+
+  void InstantiationCache::report(std::ostream &output) {
+    std::shared_lock lock(mutex);
+    output << std::format("instantiations: {}\ncache hits: {}\n", 
+        instantiations.load(), hits.load());
+    std::vector<std::pair<std::string, usize>> sorted(per_function.begin(), per_function.end());
+    std::sort(sorted.begin(), sorted.end());
+    for(const auto &[function, count]: sorted)
+      output << std::format("\t{}: {}\n", function, count);
+  }
+
+  TypeTable &InstantiationCache::getTypes() {
+    return types;
+  }
+
+  InstantiationCache &cache() {
+    static InstantiationCache global;
+    return global;
+  }
+
+} // nukac::mono
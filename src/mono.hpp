@@ -0,0 +1,85 @@
+#ifndef NUKAC_MONO_HPP
+#define NUKAC_MONO_HPP
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "helper.hpp"
+
+namespace nukac::mono {
+  using TypeId = u32;
+
+  // interned type names, ids are stable for the whole compilation.
+  class TypeTable {
+    public:
+      TypeId intern(const std::string &name);
+      const std::string &name(TypeId id);
+
+    private:
+      std::shared_mutex mutex;
+      std::unordered_map<std::string, TypeId> ids;
+      std::deque<std::string> names;
+  }; // TypeTable
+
+  // functions are keyed by their qualified name rather than by ast node,
+  // every module that imports a generic parses its own copy of it.
+  struct InstantiationKey {
+    std::string         function;
+    std::vector<TypeId> arguments;
+
+    bool operator==(const InstantiationKey &other) const = default;
+  };
+
+  struct InstantiationKeyHash {
+    usize operator()(const InstantiationKey &key) const noexcept;
+  };
+
+  struct Instance {
+    InstantiationKey key;
+    std::string      mangled_name;
+  };
+
+  class InstantiationCache {
+    public:
+      // build runs once per key, whichever thread gets there first, 
+      // everyone else waits for it and gets the same instance. function
+      // is the module qualified name, module::name.
+      const Instance &instantiate(const std::string &function, std::vector<TypeId> arguments,
+          std::function<void(const Instance &)> build = {});
+
+      void setLimit(usize limit);
+      usize getInstantiations();
+      usize getHits();
+      void report(std::ostream &output);
+
+      TypeTable &getTypes();
+
+    private:
+      struct Entry {
+        std::once_flag built;
+        Instance       instance;
+      };
+
+      std::shared_mutex mutex;
+      std::unordered_map<InstantiationKey, std::unique_ptr<Entry>, InstantiationKeyHash> entries;
+      std::unordered_map<std::string, usize> per_function;
+      TypeTable types;
+
+      std::atomic<usize> instantiations = 0;
+      std::atomic<usize> hits = 0;
+      usize limit = 1024;
+  }; // InstantiationCache
+
+  InstantiationCache &cache();
+
+} // nukac::mono
+
+#endif // NUKAC_MONO_HPP
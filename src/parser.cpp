@@ -1,11 +1,16 @@
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <format>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <sstream>
-#include <variant>
+#include <string_view>
 #include <memory>
+#include <utility>
 
 #include "lexer.hpp"
 #include "parser.hpp"
@@ -18,7 +23,7 @@ namespace nukac::parser {
 
   ParserException::ParserException(std::string what, nukac::lexer::Literal literal) {
     std::stringstream ss;
-    ss << what << "...\nat" << literal << "\n";
+    ss << what << "...\nat " << literal << "\n";
     what_did_i_do = ss.str();
   }
 
@@ -27,43 +32,302 @@ namespace nukac::parser {
   }
 
   ast::NumberExpression::NumberExpression(double val): val(val) {}
-  
-  ast::VariableExpression::VariableExpression(std::string &name, TypeExpression &type): name(name), type(type) {}
-  ast::VariableExpression::VariableExpression(std::string &name, 
-            ast::TypeExpression &type, 
-            std::vector<ast::Expression> &stored): name(name), type(type), stored(stored) {}
 
-  void ast::VariableExpression::store(std::vector<ast::Expression> stored) {
-    this->stored = stored;
+  double ast::NumberExpression::getValue() const {
+    return val;
+  }
+
+  ast::QuotedExpression::QuotedExpression(const std::string &val): val(val) {}
+
+  const std::string &ast::QuotedExpression::getValue() const {
+    return val;
+  }
+
+  ast::ReferenceExpression::ReferenceExpression(const std::string &name): name(name) {}
+
+  const std::string &ast::ReferenceExpression::getName() const {
+    return name;
+  }
+  
+  ast::VariableExpression::VariableExpression(const std::string &name, const TypeExpression &type): 
+    name(name), type(type) {}
+  ast::VariableExpression::VariableExpression(const std::string &name, 
+            const ast::TypeExpression &type, 
+            ast::ExpressionPtr stored): name(name), type(type), stored(std::move(stored)) {}
+
+  void ast::VariableExpression::store(ast::ExpressionPtr stored) {
+    this->stored = std::move(stored);
   }
 
-  std::vector<ast::Expression> ast::VariableExpression::getStored() {
+  ast::ExpressionPtr ast::VariableExpression::getStored() const {
     return stored;
   }
 
-  ast::BinaryExpression::BinaryExpression(ast::BinaryExpression::Operand operand, ast::Expression &lhs,
-      Expression &rhs): operand(operand), lhs(lhs), rhs(rhs) {}
+  const std::string &ast::VariableExpression::getName() const {
+    return name;
+  }
+
+  const ast::TypeExpression &ast::VariableExpression::getType() const {
+    return type;
+  }
+
+  ast::AssignExpression::AssignExpression(const std::string &name, ast::ExpressionPtr value):
+    name(name), value(std::move(value)) {}
+
+  const std::string &ast::AssignExpression::getName() const {
+    return name;
+  }
+
+  ast::ExpressionPtr ast::AssignExpression::getValue() const {
+    return value;
+  }
+
+  ast::BinaryExpression::BinaryExpression(ast::BinaryExpression::Operand operand, ast::ExpressionPtr lhs,
+      ast::ExpressionPtr rhs): operand(operand), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+
+  ast::BinaryExpression::Operand ast::BinaryExpression::getOperand() const {
+    return operand;
+  }
+
+  ast::ExpressionPtr ast::BinaryExpression::getLhs() const {
+    return lhs;
+  }
+
+  ast::ExpressionPtr ast::BinaryExpression::getRhs() const {
+    return rhs;
+  }
+
+  ast::ReturnExpression::ReturnExpression(ast::ExpressionPtr value): value(std::move(value)) {}
+
+  ast::ExpressionPtr ast::ReturnExpression::getValue() const {
+    return value;
+  }
+
+  ast::TryExpression::TryExpression(ast::ExpressionPtr value): value(std::move(value)) {}
+
+  ast::ExpressionPtr ast::TryExpression::getValue() const {
+    return value;
+  }
+
+  ast::ErrorExpression::ErrorExpression(const std::string &set, const std::string &error):
+    set(set), error(error) {}
+
+  const std::string &ast::ErrorExpression::getSet() const {
+    return set;
+  }
+
+  const std::string &ast::ErrorExpression::getError() const {
+    return error;
+  }
+
+  ast::DeferExpression::DeferExpression(bool on_error, std::vector<ast::ExpressionPtr> body):
+    on_error(on_error), body(std::move(body)) {}
+
+  bool ast::DeferExpression::onError() const {
+    return on_error;
+  }
+
+  const std::vector<ast::ExpressionPtr> &ast::DeferExpression::getBody() const {
+    return body;
+  }
+
+  ast::BlockExpression::BlockExpression(std::vector<ast::ExpressionPtr> body): body(std::move(body)) {}
+
+  const std::vector<ast::ExpressionPtr> &ast::BlockExpression::getBody() const {
+    return body;
+  }
+
   ast::CallExpression::CallExpression(const std::string &callee, 
-      std::vector<ast::Expression> args): callee(callee), args(args) {}
+      std::vector<ast::ExpressionPtr> args): callee(callee), args(std::move(args)) {}
 
+  ast::CallExpression::CallExpression(const std::string &callee, std::vector<std::string> type_args,
+      std::vector<ast::ExpressionPtr> args): callee(callee), type_args(std::move(type_args)), args(std::move(args)) {}
 
-  ast::TypeExpression::TypeExpression(const std::string &name, ast::Expression &of_other_type): 
-    name(name), of_other_type(of_other_type) {}
+  const std::string &ast::CallExpression::getCallee() const {
+    return callee;
+  }
+
+  const std::vector<std::string> &ast::CallExpression::getTypeArgs() const {
+    return type_args;
+  }
+
+  const std::vector<ast::ExpressionPtr> &ast::CallExpression::getArgs() const {
+    return args;
+  }
 
-  std::string ast::TypeExpression::TypeExpression::getName() {
+
+  ast::TypeExpression::TypeExpression(const std::string &name): name(name) {}
+  ast::TypeExpression::TypeExpression(const std::string &name, ast::ExpressionPtr of_other_type): 
+    name(name), of_other_type(std::move(of_other_type)) {}
+
+  std::string ast::TypeExpression::TypeExpression::getName() const {
     return name; 
   }
-  ast::Expression &ast::TypeExpression::TypeExpression::referencingType() {
+  ast::ExpressionPtr ast::TypeExpression::TypeExpression::referencingType() {
     return of_other_type;
   }
   
-  ast::StructExpression::StructExpression(const std::string &name, std::vector<ast::Expression> contents):
+  ast::StructExpression::StructExpression(const std::string &name, std::vector<ast::ExpressionPtr> contents):
     name(name), contents(std::move(contents)) {}
-  ast::Prototype::Prototype(const std::string &name, ast::TypeExpression &return_type, 
-      std::vector<ast::VariableExpression> args):
+  ast::StructExpression::StructExpression(const std::string &name, std::vector<ast::Field> fields,
+      bool pub, bool abi_fixed):
+    name(name), fields(std::move(fields)), pub(pub), abi_fixed(abi_fixed) {}
+
+  const std::string &ast::StructExpression::getName() const {
+    return name;
+  }
+
+  const std::vector<ast::Field> &ast::StructExpression::getFields() const {
+    return fields;
+  }
+
+  void ast::StructExpression::setFields(std::vector<ast::Field> fields) {
+    this->fields = std::move(fields);
+  }
+
+  bool ast::StructExpression::isLayoutFixed() const {
+    return pub || abi_fixed;
+  }
+
+  ast::Prototype::Prototype(const std::string &name, const ast::TypeExpression &return_type, 
+      std::vector<ast::VariableExpression> args,
+      usize where_character, usize where_line):
+    where_character(where_character), where_line(where_line),
     name(name), return_type(return_type), args(std::move(args)) {}
-  ast::Function::Function(Prototype &proto, std::vector<ast::Expression> body):
-    proto(proto), body(std::move(body)) {}
+
+  const std::string &ast::Prototype::getName() const {
+    return name;
+  }
+
+  const ast::TypeExpression &ast::Prototype::getReturnType() const {
+    return return_type;
+  }
+
+  const std::vector<ast::VariableExpression> &ast::Prototype::getVariables() const {
+    return args;
+  }
+
+  void ast::Prototype::setErrorSet(const std::string &error_set) {
+    this->error_set = error_set;
+  }
+
+  const std::string &ast::Prototype::getErrorSet() const {
+    return error_set;
+  }
+
+  bool ast::Prototype::canFail() const {
+    return !error_set.empty();
+  }
+
+  void ast::Prototype::setGenerics(std::vector<ast::GenericParameter> generics) {
+    this->generics = std::move(generics);
+  }
+
+  const std::vector<ast::GenericParameter> &ast::Prototype::getGenerics() const {
+    return generics;
+  }
+
+  bool ast::Prototype::isGeneric() const {
+    return !generics.empty();
+  }
+
+  void ast::Prototype::setModule(const std::string &module) {
+    this->module = module;
+  }
+
+  const std::string &ast::Prototype::getModule() const {
+    return module;
+  }
+
+  ast::Function::Function(Prototype proto, std::vector<ast::ExpressionPtr> body):
+    proto(std::move(proto)), body(std::move(body)), parsed(true), body_begin(0), body_end(0) {}
+  ast::Function::Function(Prototype proto, usize body_begin, usize body_end):
+    proto(std::move(proto)), parsed(false), body_begin(body_begin), body_end(body_end) {}
+
+  const ast::Prototype &ast::Function::getPrototype() const {
+    return proto;
+  }
+
+  const std::vector<ast::ExpressionPtr> &ast::Function::getBody() const {
+    return body;
+  }
+
+  bool ast::Function::isParsed() const {
+    return parsed;
+  }
+
+  usize ast::Function::getBodyBegin() const {
+    return body_begin;
+  }
+
+  usize ast::Function::getBodyEnd() const {
+    return body_end;
+  }
+
+  void ast::Function::setBody(std::vector<ast::ExpressionPtr> body) {
+    this->body = std::move(body);
+    parsed = true;
+  }
+
+  u16 ast::errorTag(const std::string &error) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, u16> tags;
+
+    std::lock_guard lock(mutex);
+    auto found = tags.find(error);
+    if(found != tags.end()) return found->second;
+    if(tags.size() == std::numeric_limits<u16>::max())
+      throw ParserException("Too many distinct errors.", error);
+    return tags.emplace(error, static_cast<u16>(tags.size() + 1)).first->second;
+  }
+
+  // tags are handed out in declaration order.
+  ast::ErrorSet::ErrorSet(const std::string &name, std::vector<std::string> errors):
+    name(name), errors(std::move(errors)) {
+    for(const std::string &error: this->errors) errorTag(error);
+  }
+
+  const std::string &ast::ErrorSet::getName() const {
+    return name;
+  }
+
+  const std::vector<std::string> &ast::ErrorSet::getErrors() const {
+    return errors;
+  }
+
+  u16 ast::ErrorSet::tagOf(const std::string &error) const {
+    auto found = std::find(errors.begin(), errors.end(), error);
+    if(found == errors.end())
+      throw ParserException(std::format("{} is not part of the error set", error), name);
+    return errorTag(error);
+  }
+
+  ast::Trait::Trait(const std::string &name, std::vector<ast::Prototype> prototypes):
+    name(name), prototypes(std::move(prototypes)) {}
+
+  const std::string &ast::Trait::getName() const {
+    return name;
+  }
+
+  const std::vector<ast::Prototype> &ast::Trait::getPrototypes() const {
+    return prototypes;
+  }
+
+  ast::Implementation::Implementation(const std::string &trait, const std::string &type,
+      std::vector<ast::Function> functions):
+    trait(trait), type(type), functions(std::move(functions)) {}
+
+  const std::string &ast::Implementation::getTrait() const {
+    return trait;
+  }
+
+  const std::string &ast::Implementation::getType() const {
+    return type;
+  }
+
+  const std::vector<ast::Function> &ast::Implementation::getFunctions() const {
+    return functions;
+  }
 
 #pragma clang diagnostic ignored "-Wunused" 
   // types, functions, traits
@@ -93,12 +357,24 @@ namespace nukac::parser {
   constexpr const std::string import_kw = "import";
   constexpr const std::string module_kw = "module";
 
+  // every scope starts out knowing these.
+  constexpr std::string_view primitive_types[] = {
+    "void", "bool",
+    "u8", "u16", "u32", "u64", "usize",
+    "i8", "i16", "i32", "i64", "size",
+    "f32", "f64",
+  };
+
 
 #define GET_PRSR(var, literal, msg) \
-  try { \
-    var = std::get<typeof(var)>(literal.literal_variant); \
-  } catch(...) { \
+  if(!literal.isString()) \
     throw ParserException(msg, literal); \
+  var = literal.literal_string;
+
+  static ast::ExpressionPtr parserAt(const lexer::Literal &literal, ast::ExpressionPtr expression) {
+    expression->where_character = literal.where_character;
+    expression->where_line = literal.where_line;
+    return expression;
   }
 
   inline void Parser::parserPFunction() {
@@ -106,12 +382,23 @@ namespace nukac::parser {
     Literal return_type_l = lexer.swallow();
     std::string return_type_n;
     GET_PRSR(return_type_n, return_type_l, "Invalid token in function declaration");
-    ast::TypeExpression &return_type = scope_types[return_type_n];
+
+    std::string error_set;
+    if(lexer.next(Token::exclamation)) {
+      lexer.swallowZ();
+      error_set = return_type_n;
+      Literal payload_l = lexer.swallow();
+      GET_PRSR(return_type_n, payload_l, "Invalid token in function declaration");
+    }
+    ast::TypeExpression return_type(return_type_n);
 
     Literal fun_name_l = lexer.swallow();
     std::string fun_name;
     GET_PRSR(fun_name, fun_name_l, "Invalid token in function declaration.");
 
+    std::vector<ast::GenericParameter> generics;
+    if(lexer.next(Token::lsqbrace)) generics = parserPGenerics();
+
     if(!lexer.next(Token::lparen)) {
       Literal l = lexer.swallow();
       throw ParserException("Invalid token in function declaration.", l);
@@ -133,135 +420,554 @@ namespace nukac::parser {
       Literal type_l = lexer.swallow();
       std::string type_n;
       GET_PRSR(type_n, type_l, "Invalid token in function declaration.");
-      ast::TypeExpression type = scope_types[type_n];
-      ast::VariableExpression variable(name_n, type);
+      ast::VariableExpression variable(name_n, ast::TypeExpression(type_n));
+      variable.where_character = name_l.where_character;
+      variable.where_line = name_l.where_line;
 
       arguments.push_back(variable);
 
-      if(!lexer.next(Token::comma) && !lexer.next(Token::rparen)) {
+      if(lexer.next(Token::comma)) lexer.swallowZ();
+      else if(!lexer.next(Token::rparen)) {
         Literal l = lexer.swallow();
         throw ParserException("Invalid token in function declaration.", l);
       }
     }
-    
+    lexer.swallowZ();
 
-    ast::Prototype proto(fun_name, return_type, arguments);
-    if(lexer.next(Token::lcrbrace)){
-      #define PARSER_WHILE_CONDITIONAL lexer.next(lexer::Token::rcrbrace)
+    ast::Prototype proto(fun_name, return_type, arguments,
+        fun_name_l.where_character, fun_name_l.where_line);
+    proto.setGenerics(std::move(generics));
+    proto.setModule(module);
+    proto.setErrorSet(error_set);
+    if(lexer.next(Token::lcrbrace) && lazy_bodies) {
+      const usize body_begin = lexer.position();
+      const usize body_end = lexer.skipBalanced(Token::lcrbrace, Token::rcrbrace);
+      functions.push_back(ast::Function(proto, body_begin, body_end));
+    } else if(lexer.next(Token::lcrbrace)){
+      functions.push_back(ast::Function(proto, parserPBody()));
+    } else if(!lexer.swallow(Token::semicolon)){
+      throw ParserException("Invalid token in function declaration.", fun_name_l);
+    }
+    prototypes.push_back(proto);
+  }
 
-      Parser subnode(lexer, variables, expressions, prototypes, functions, scope_types, Scope::function);
-      #undef PARSER_WHILE_CONDITIONAL  
+  // { statement* }
+  inline std::vector<ast::ExpressionPtr> Parser::parserPBody() {
+    using namespace nukac::lexer;
+    lexer.swallowZ();
 
-      ast::Function func(proto, subnode.getExpressions());
-    } else if(!lexer.next(Token::semicolon)){
-      throw ParserException("Invalid token in function declaration.", lexer.swallow());
+    std::vector<ast::ExpressionPtr> body;
+    while(!lexer.next(Token::rcrbrace)) {
+      ast::ExpressionPtr statement = parserPStatement();
+      if(statement) body.push_back(statement);
     }
-    prototypes.push_back(proto);
+    lexer.swallowZ();
+    return body;
+  }
+
+  // null for statements that leave nothing behind, like directives.
+  inline ast::ExpressionPtr Parser::parserPStatement() {
+    using namespace nukac::lexer;
+    Literal literal = lexer.swallow();
+
+    if(Token::dollar == literal) {
+      parserPDirective(literal);
+      return nullptr;
+    } else if(return_kw == literal) {
+      return parserPReturn(literal);
+    } else if(defer_kw == literal || errdefer_kw == literal) {
+      return parserPDefer(literal);
+    } else if(Token::lcrbrace == literal) {
+      lexer.seek(lexer.position() - 1);
+      return parserAt(literal, std::make_shared<ast::BlockExpression>(parserPBody()));
+    } else if(function_kw == literal || struct_kw == literal || trait_kw == literal ||
+        implements_kw == literal || error_kw == literal) {
+      throw ParserException("Declarations are only allowed at the top level.", literal);
+    } else if(literal.isString() && lexer.next(Token::colon)) {
+      return parserPVariable(literal);
+    } else if(literal.isString() && lexer.next(Token::equals)) {
+      return parserPVariableAssign(literal);
+    }
+
+    lexer.seek(lexer.position() - 1);
+    ast::ExpressionPtr expression = parserPValue();
+    if(!lexer.swallow(Token::semicolon))
+      throw ParserException("Expected ; after an expression.", literal);
+    return expression;
   }
 
-  inline void Parser::parserPVariable(std::string name) {
+  // defer statement, errdefer statement, a block is a statement too.
+  inline ast::ExpressionPtr Parser::parserPDefer(lexer::Literal literal) {
+    std::vector<ast::ExpressionPtr> body;
+    if(ast::ExpressionPtr statement = parserPStatement()) body.push_back(statement);
+    return parserAt(literal, std::make_shared<ast::DeferExpression>(errdefer_kw == literal, std::move(body)));
+  }
+
+  inline ast::ExpressionPtr Parser::parserPReturn(lexer::Literal literal) {
+    using namespace nukac::lexer;
+    ast::ExpressionPtr value;
+    if(!lexer.next(Token::semicolon)) value = parserPExpression();
+    if(!lexer.swallow(Token::semicolon))
+      throw ParserException("Expected ; after return.", literal);
+    return parserAt(literal, std::make_shared<ast::ReturnExpression>(value));
+  }
+
+  // name: type [= expression];
+  inline ast::ExpressionPtr Parser::parserPVariable(lexer::Literal name) {
     using namespace lexer;
     lexer.swallowZ();
     Literal type_l = lexer.swallow();
     std::string type_n;
-    GET_PRSR(type_n, type_l, "Invalid token in variable decleration.");
-    ast::VariableExpression variable(name, scope_types[name]);
-    if(lexer.next(Token::equals)) {
-      #define PARSER_WHILE_CONDITIONAL lexer.next(lexer::Token::semicolon);
-      
-      Parser subnode(lexer, variables, expressions, prototypes, functions, scope_types, Scope::variable);
-      #undef PARSER_WHILE_CONDITIONAL
+    GET_PRSR(type_n, type_l, "Invalid token in variable declaration.");
 
-      variable.store(subnode.getExpressions());
+    auto variable = std::make_shared<ast::VariableExpression>(name.literal_string, ast::TypeExpression(type_n));
+    if(lexer.next(Token::equals)) {
+      lexer.swallowZ();
+      variable->store(parserPValue());
     }
-    
-    variables[name] = variable;
-    expressions.push_back(variable);
 
-    if(!lexer.next(Token::semicolon)) {
-      throw ParserException("Invalid token in variable declaration", lexer.swallow());
-    }
+    if(!lexer.swallow(Token::semicolon))
+      throw ParserException("Invalid token in variable declaration.", name);
+    return parserAt(name, variable);
   }
 
-  inline void Parser::parserPVariableAssign(std::string name) {
+  // name = expression;
+  inline ast::ExpressionPtr Parser::parserPVariableAssign(lexer::Literal name) {
     using namespace lexer;
     lexer.swallowZ();
+    ast::ExpressionPtr value = parserPValue();
 
+    if(!lexer.swallow(Token::semicolon))
+      throw ParserException("Invalid token in a variable assignment.", name);
+    return parserAt(name, std::make_shared<ast::AssignExpression>(name.literal_string, value));
+  }
 
+  // an expression, or try expression where a statement takes its value.
+  inline ast::ExpressionPtr Parser::parserPValue() {
+    if(!lexer.next(try_kw)) return parserPExpression();
+    lexer::Literal literal = lexer.swallow();
+    return parserAt(literal, std::make_shared<ast::TryExpression>(parserPExpression()));
+  }
 
-    Parser subnode(lexer, expressions, prototypes, functions, scope_types, Scope::variable);
+  inline ast::ExpressionPtr Parser::parserPExpression() {
+    ast::ExpressionPtr lhs = parserPAnd();
+    while(lexer.next(or_kw)) {
+      lexer::Literal op = lexer.swallow();
+      lhs = parserAt(op, std::make_shared<ast::BinaryExpression>(
+            ast::BinaryExpression::Operand::oor, lhs, parserPAnd()));
+    }
+    return lhs;
+  }
 
+  inline ast::ExpressionPtr Parser::parserPAnd() {
+    ast::ExpressionPtr lhs = parserPComparison();
+    while(lexer.next(and_kw)) {
+      lexer::Literal op = lexer.swallow();
+      lhs = parserAt(op, std::make_shared<ast::BinaryExpression>(
+            ast::BinaryExpression::Operand::oand, lhs, parserPComparison()));
+    }
+    return lhs;
   }
 
-  void Parser::parserInternal() {
-    nukac::lexer::Literal literal = lexer.swallow();
+  inline ast::ExpressionPtr Parser::parserPComparison() {
     using namespace nukac::lexer;
-    if(literal.literal_variant == Token::dollar) {
-      if(lexer.next("println")) {
+    using Operand = ast::BinaryExpression::Operand;
+    ast::ExpressionPtr lhs = parserPAdditive();
+    while(lexer.next(Token::left_inequality) || lexer.next(Token::right_inequality)) {
+      Literal op = lexer.swallow();
+      const Operand operand = Token::left_inequality == op ? Operand::oless : Operand::ogreater;
+      lhs = parserAt(op, std::make_shared<ast::BinaryExpression>(operand, lhs, parserPAdditive()));
+    }
+    return lhs;
+  }
+
+  inline ast::ExpressionPtr Parser::parserPAdditive() {
+    using namespace nukac::lexer;
+    using Operand = ast::BinaryExpression::Operand;
+    ast::ExpressionPtr lhs = parserPMultiplicative();
+    while(lexer.next(Token::plus) || lexer.next(Token::dash)) {
+      Literal op = lexer.swallow();
+      const Operand operand = Token::plus == op ? Operand::oplus : Operand::ominus;
+      lhs = parserAt(op, std::make_shared<ast::BinaryExpression>(operand, lhs, parserPMultiplicative()));
+    }
+    return lhs;
+  }
+
+  inline ast::ExpressionPtr Parser::parserPMultiplicative() {
+    using namespace nukac::lexer;
+    using Operand = ast::BinaryExpression::Operand;
+    ast::ExpressionPtr lhs = parserPUnary();
+    while(lexer.next(Token::star) || lexer.next(Token::slash) || lexer.next(Token::percent)) {
+      Literal op = lexer.swallow();
+      const Operand operand = Token::star == op ? Operand::otimes : 
+        Token::slash == op ? Operand::odivide : Operand::omodulo;
+      lhs = parserAt(op, std::make_shared<ast::BinaryExpression>(operand, lhs, parserPUnary()));
+    }
+    return lhs;
+  }
+
+  inline ast::ExpressionPtr Parser::parserPUnary() {
+    if(lexer.next(not_kw)) {
+      lexer::Literal op = lexer.swallow();
+      return parserAt(op, std::make_shared<ast::BinaryExpression>(
+            ast::BinaryExpression::Operand::onot, nullptr, parserPUnary()));
+    }
+    return parserPPrimary();
+  }
+
+  // number, "quoted", name, Set.Error, name(args), name[Types](args), (expression)
+  inline ast::ExpressionPtr Parser::parserPPrimary() {
+    using namespace nukac::lexer;
+    Literal literal = lexer.swallow();
+
+    if(Token::lparen == literal) {
+      ast::ExpressionPtr inner = parserPExpression();
+      if(!lexer.swallow(Token::rparen))
+        throw ParserException("Expected ) to close the expression.", literal);
+      return inner;
+    } else if(literal.isQuoted()) {
+      return parserAt(literal, std::make_shared<ast::QuotedExpression>(literal.literal_string));
+    } else if(!literal.isString()) {
+      throw ParserException("Invalid token in expression.", literal);
+    }
+
+    const std::string &word = literal.literal_string;
+    if(std::isdigit(static_cast<u8>(word.front()))) {
+      if(!std::all_of(word.begin(), word.end(), [](char c) { return std::isdigit(static_cast<u8>(c)); }))
+        throw ParserException("Invalid number.", literal);
+      double value = 0;
+      const auto [end, error] = std::from_chars(word.data(), word.data() + word.size(), value);
+      if(error != std::errc() || end != word.data() + word.size())
+        throw ParserException("Number literal out of range.", literal);
+      return parserAt(literal, std::make_shared<ast::NumberExpression>(value));
+    }
+
+    // errors are the only dotted names so far.
+    if(lexer.next(Token::dot)) {
+      lexer.swallowZ();
+      Literal error_l = lexer.swallow();
+      std::string error;
+      GET_PRSR(error, error_l, "Invalid token in error value.");
+      return parserAt(literal, std::make_shared<ast::ErrorExpression>(word, error));
+    }
+
+    if(!lexer.next(Token::lsqbrace) && !lexer.next(Token::lparen))
+      return parserAt(literal, std::make_shared<ast::ReferenceExpression>(word));
+
+    std::vector<std::string> type_args;
+    if(lexer.next(Token::lsqbrace)) {
+      lexer.swallowZ();
+      while(!lexer.next(Token::rsqbrace)) {
+        Literal type_l = lexer.swallow();
+        std::string type;
+        GET_PRSR(type, type_l, "Invalid token in type arguments.");
+        type_args.push_back(type);
+        if(lexer.next(Token::comma)) lexer.swallowZ();
+        else if(!lexer.next(Token::rsqbrace))
+          throw ParserException("Invalid token in type arguments.", lexer.swallow());
+      }
+      lexer.swallowZ();
+    }
+
+    if(!lexer.swallow(Token::lparen))
+      throw ParserException("Expected ( after type arguments.", literal);
+    std::vector<ast::ExpressionPtr> args;
+    while(!lexer.next(Token::rparen)) {
+      args.push_back(parserPExpression());
+      if(lexer.next(Token::comma)) lexer.swallowZ();
+      else if(!lexer.next(Token::rparen))
+        throw ParserException("Invalid token in call arguments.", lexer.swallow());
+    }
+    lexer.swallowZ();
+
+    return parserAt(literal, std::make_shared<ast::CallExpression>(word, type_args, args));
+  }
+
+  // struct Name { a: u8; $cold b: u64; }
+  inline void Parser::parserPStructure(bool pub, bool abi_fixed) {
+    using namespace nukac::lexer;
+    Literal name_l = lexer.swallow();
+    std::string name;
+    GET_PRSR(name, name_l, "Invalid token in struct declaration.");
+
+    if(!lexer.swallow(Token::lcrbrace))
+      throw ParserException("Invalid token in struct declaration.", name_l);
+
+    std::vector<ast::Field> fields;
+    while(!lexer.next(Token::rcrbrace)) {
+      ast::Field field{ .access = ast::Field::Access::unknown };
+      if(lexer.next(Token::dollar)) {
         lexer.swallowZ();
-        Literal p = lexer.swallow();
-        std::cout << p << "\n";
-      } else if(lexer.next("error")) {
+        if(lexer.next("hot")) field.access = ast::Field::Access::hot;
+        else if(lexer.next("cold")) field.access = ast::Field::Access::cold;
+        else throw ParserException("Unknown field annotation.", lexer.swallow());
+        lexer.swallowZ();
+      }
+
+      Literal field_l = lexer.swallow();
+      GET_PRSR(field.name, field_l, "Invalid token in struct field.");
+      if(!lexer.swallow(Token::colon))
+        throw ParserException("Invalid token in struct field.", field_l);
+      Literal type_l = lexer.swallow();
+      GET_PRSR(field.type, type_l, "Invalid token in struct field.");
+      if(!lexer.swallow(Token::semicolon))
+        throw ParserException("Invalid token in struct field.", type_l);
+
+      fields.push_back(field);
+    }
+    lexer.swallowZ();
+
+    structures.push_back(ast::StructExpression(name, std::move(fields), pub, abi_fixed));
+    scope_types.insert_or_assign(name, ast::TypeExpression(name));
+  }
+
+  // error Name { A, B }
+  inline void Parser::parserPErrorSet() {
+    using namespace nukac::lexer;
+    Literal name_l = lexer.swallow();
+    std::string name;
+    GET_PRSR(name, name_l, "Invalid token in error set declaration.");
+
+    if(!lexer.swallow(Token::lcrbrace))
+      throw ParserException("Invalid token in error set declaration.", name_l);
+
+    std::vector<std::string> errors;
+    while(!lexer.next(Token::rcrbrace)) {
+      Literal error_l = lexer.swallow();
+      std::string error;
+      GET_PRSR(error, error_l, "Invalid token in error set declaration.");
+      if(std::find(errors.begin(), errors.end(), error) != errors.end())
+        throw ParserException("Duplicate error in error set.", error_l);
+      errors.push_back(error);
+
+      if(lexer.next(Token::comma)) lexer.swallowZ();
+      else if(!lexer.next(Token::rcrbrace))
+        throw ParserException("Invalid token in error set declaration.", lexer.swallow());
+    }
+    lexer.swallowZ();
+
+    error_sets.push_back(ast::ErrorSet(name, std::move(errors)));
+  }
+
+  // [T: Trait, U]
+  inline std::vector<ast::GenericParameter> Parser::parserPGenerics() {
+    using namespace nukac::lexer;
+    lexer.swallowZ();
+    std::vector<ast::GenericParameter> generics;
+
+    while(!lexer.next(Token::rsqbrace)) {
+      ast::GenericParameter generic;
+      Literal name_l = lexer.swallow();
+      GET_PRSR(generic.name, name_l, "Invalid token in generic parameters.");
+
+      if(lexer.next(Token::colon)) {
         lexer.swallowZ();
-        Literal what = lexer.swallow();
-        throw ParserException("Custom compile error.", what);
+        Literal bound_l = lexer.swallow();
+        GET_PRSR(generic.bound, bound_l, "Invalid token in generic parameters.");
       }
-    } else if(literal.literal_variant == function_kw) {
+      generics.push_back(generic);
+
+      if(lexer.next(Token::comma)) lexer.swallowZ();
+      else if(!lexer.next(Token::rsqbrace))
+        throw ParserException("Invalid token in generic parameters.", lexer.swallow());
+    }
+    lexer.swallowZ();
+    return generics;
+  }
+
+  // trait Name { fn ...; }, Self in the prototypes is the implementing type.
+  inline void Parser::parserPTrait() {
+    using namespace nukac::lexer;
+    Literal name_l = lexer.swallow();
+    std::string name;
+    GET_PRSR(name, name_l, "Invalid token in trait declaration.");
+
+    if(!lexer.swallow(Token::lcrbrace))
+      throw ParserException("Invalid token in trait declaration.", name_l);
+
+    const usize prototypes_before = prototypes.size();
+    const usize functions_before = functions.size();
+    while(!lexer.next(Token::rcrbrace)) {
+      if(!lexer.next(function_kw))
+        throw ParserException("Only functions can be declared in a trait.", lexer.swallow());
+      Literal l = lexer.swallow();
       parserPFunction();
-    } else if(literal.literal_variant == return_kw && scope == Scope::function) {
-      
-    } else if(literal.literal_variant == return_kw && scope != Scope::function) {
+      if(functions.size() != functions_before)
+        throw ParserException("Trait functions can't have a body.", l);
+    }
+    lexer.swallowZ();
+
+    std::vector<ast::Prototype> declared(
+        std::make_move_iterator(prototypes.begin() + prototypes_before),
+        std::make_move_iterator(prototypes.end()));
+    while(prototypes.size() > prototypes_before) prototypes.pop_back();
+    traits.push_back(ast::Trait(name, std::move(declared)));
+  }
+
+  // implements Trait: Type { fn ... }
+  inline void Parser::parserPImplements() {
+    using namespace nukac::lexer;
+    Literal trait_l = lexer.swallow();
+    std::string trait;
+    GET_PRSR(trait, trait_l, "Invalid token in trait implementation.");
+
+    if(!lexer.swallow(Token::colon))
+      throw ParserException("Invalid token in trait implementation.", trait_l);
+    Literal type_l = lexer.swallow();
+    std::string type;
+    GET_PRSR(type, type_l, "Invalid token in trait implementation.");
+
+    if(!lexer.swallow(Token::lcrbrace))
+      throw ParserException("Invalid token in trait implementation.", type_l);
+
+    // implementations aren't reachable by name, so never lazy.
+    const bool lazy = std::exchange(lazy_bodies, false);
+    const usize prototypes_before = prototypes.size();
+    const usize functions_before = functions.size();
+    while(!lexer.next(Token::rcrbrace)) {
+      if(!lexer.next(function_kw))
+        throw ParserException("Only functions can be implemented for a trait.", lexer.swallow());
+      Literal l = lexer.swallow();
+      const usize functions_at = functions.size();
+      parserPFunction();
+      if(functions.size() == functions_at)
+        throw ParserException("Trait implementations need a body.", l);
+    }
+    lexer.swallowZ();
+    lazy_bodies = lazy;
+
+    std::vector<ast::Function> implemented(
+        std::make_move_iterator(functions.begin() + functions_before),
+        std::make_move_iterator(functions.end()));
+    while(functions.size() > functions_before) functions.pop_back();
+    while(prototypes.size() > prototypes_before) prototypes.pop_back();
+    ast::Implementation implementation(trait, type, std::move(implemented));
+    implementation.where_character = trait_l.where_character;
+    implementation.where_line = trait_l.where_line;
+    implementations.push_back(std::move(implementation));
+  }
+
+  void Parser::parserPDirective(lexer::Literal dollar) {
+    using namespace nukac::lexer;
+    if(lexer.next("println")) {
+      lexer.swallowZ();
+      Literal p = lexer.swallow();
+      std::cout << p << "\n";
+    } else if(lexer.next("error")) {
+      lexer.swallowZ();
+      Literal what = lexer.swallow();
+      throw ParserException("Custom compile error.", what);
+    } else if(lexer.next("abi")) {
+      lexer.swallowZ();
+      if(!lexer.swallow(struct_kw))
+        throw ParserException("$abi only applies to structs.", dollar);
+      parserPStructure(false, true);
+      return;
+    } else if(lexer.next(Token::string)) {
+      // compile time call, evaluation isn't there yet but the callee's
+      // body has to be. the callee may be declared further down or be
+      // the function this body belongs to, so it's looked up once 
+      // parsing is done, the same in eager and lazy mode.
+      compile_time_calls.push_back(lexer.swallow());
+    } else {
+      throw ParserException("Unknown directive.", dollar);
+    }
+
+    if(lexer.next(Token::semicolon)) lexer.swallowZ();
+  }
+
+  void Parser::parserInternal() {
+    nukac::lexer::Literal literal = lexer.swallow();
+    using namespace nukac::lexer;
+    if(Token::dollar == literal) {
+      parserPDirective(literal);
+    } else if(function_kw == literal) {
+      parserPFunction();
+    } else if(struct_kw == literal) {
+      parserPStructure(false, false);
+    } else if(pub_kw == literal && lexer.next(struct_kw)) {
+      lexer.swallowZ();
+      parserPStructure(true, false);
+    } else if(error_kw == literal) {
+      parserPErrorSet();
+    } else if(trait_kw == literal) {
+      parserPTrait();
+    } else if(implements_kw == literal) {
+      parserPImplements();
+    } else if(return_kw == literal) {
       throw ParserException("Return in a non-functional scope.", literal);
-    } else if(lexer.next(Token::colon)) {
-      std::string name;
-      GET_PRSR(name, literal, "Invalid token in variable declaration.");
-      parserPVariable(name);
-    } else if(lexer.next(Token::equals)) {
-      std::string name;
-      GET_PRSR(name, literal, "Invalid token in a variable assignment.");
-      parserPVariableAssign(name);
+    } else if(literal.isString() && lexer.next(Token::colon)) {
+      ast::ExpressionPtr variable = parserPVariable(literal);
+      variables.insert_or_assign(literal.literal_string, 
+          static_cast<ast::VariableExpression &>(*variable));
+      expressions.push_back(variable);
+    } else if(literal.isString() && lexer.next(Token::equals)) {
+      expressions.push_back(parserPVariableAssign(literal));
+    } else {
+      throw ParserException("Unexpected token at the top level.", literal);
     }
   }
 
-  Parser::Parser(lexer::Lexer &lexer): lexer(lexer) {
-    #ifndef PARSER_WHILE_CONDITIONAL
-    #define PARSER_WHILE_CONDITIONAL lexer.isEoC()
-    #endif
-    
+  Parser::Parser(lexer::Lexer &lexer): Parser(lexer, false) {}
+
+  Parser::Parser(lexer::Lexer &lexer, bool lazy_bodies): Parser(lexer, lazy_bodies, "root") {}
+
+  Parser::Parser(lexer::Lexer &lexer, bool lazy_bodies, const std::string &module): 
+    lexer(lexer), lazy_bodies(lazy_bodies), module(module) {
     scope = Scope::structure;
+    for(std::string_view primitive: primitive_types)
+      scope_types.insert_or_assign(std::string(primitive), ast::TypeExpression(std::string(primitive)));
 
-    while(PARSER_WHILE_CONDITIONAL) {
-      parserInternal();      
+    while(!lexer.isEoC()) {
+      parserInternal();
     }
+    parserCompileTimeCalls();
   }
-  
-  #undef PARSER_WHILE_CONDITIONAL
-
-  Parser::Parser(nukac::lexer::Lexer &lexer, 
-      std::vector<ast::Expression> expressions,
-      std::vector<ast::Prototype> prototypes,
-      std::vector<ast::Function> functions,
-      std::unordered_map<std::string, ast::TypeExpression> scope_types,
-      Scope scope): lexer(lexer),
-      expressions(std::move(expressions)),
-      prototypes(std::move(prototypes)),
-      functions(std::move(functions)), 
-      scope_types(std::move(scope_types)),
-      scope(scope)
-      
-  {
-    #ifndef PARSER_WHILE_CONDITIONAL
-    #define PARSER_WHILE_CONDITIONAL lexer.isEoC()
-    #endif
 
-    while(PARSER_WHILE_CONDITIONAL) {
-      parserInternal();
+  void Parser::parserCompileTimeCalls() {
+    // materializing a callee can queue more calls.
+    while(!compile_time_calls.empty()) {
+      const lexer::Literal callee = std::move(compile_time_calls.back());
+      compile_time_calls.pop_back();
+      if(materialize(callee.literal_string).empty())
+        throw ParserException("Compile time call to an undeclared function.", callee);
     }
   }
 
-  #undef PARSER_WHILE_CONDITIONAL
+  std::vector<ast::Function> Parser::materialize(const std::string &name) {
+    std::vector<ast::Function> found;
+    for(ast::Function &function: functions) {
+      if(function.getPrototype().getName() != name) continue;
+      // a body naming its own function through $ only needs it once.
+      if(function.isParsed() || !materializing.insert(function.getBodyBegin()).second) {
+        found.push_back(function);
+        continue;
+      }
+
+      const usize resume_at = lexer.position();
+      lexer.seek(function.getBodyBegin());
+      lexer.swallowZ();
+
+      std::vector<ast::ExpressionPtr> body;
+      while(lexer.position() < function.getBodyEnd()) {
+        ast::ExpressionPtr statement = parserPStatement();
+        if(statement) body.push_back(statement);
+      }
+      if(lexer.position() != function.getBodyEnd())
+        throw ParserException("Statement runs past the end of the function body.", 
+            function.getPrototype().getName());
+
+      lexer.seek(resume_at);
+      materializing.erase(function.getBodyBegin());
+      function.setBody(std::move(body));
+      found.push_back(function);
+    }
+    // the bodies just parsed can hold $ calls of their own.
+    parserCompileTimeCalls();
+    return found;
+  }
 
-  std::vector<ast::Expression> Parser::getExpressions() {
+  std::vector<ast::ExpressionPtr> Parser::getExpressions() {
     return expressions;
   }
 
@@ -270,8 +976,33 @@ namespace nukac::parser {
   }
 
   std::vector<ast::Function> Parser::getFunctions() {
-    return std::move(functions);
+    return functions;
   }
+
+  std::vector<ast::Trait> Parser::getTraits() {
+    return traits;
+  }
+
+  std::vector<ast::Implementation> Parser::getImplementations() {
+    return implementations;
+  }
+
+  std::vector<ast::StructExpression> Parser::getStructures() {
+    return structures;
+  }
+
+  std::vector<ast::ErrorSet> Parser::getErrorSets() {
+    return error_sets;
+  }
+
+  std::unordered_map<std::string, ast::TypeExpression> Parser::getTypes() {
+    return scope_types;
+  }
+
+  std::unordered_map<std::string, ast::VariableExpression> Parser::getVariables() {
+    return variables;
+  }
+
   const Scope Parser::getScope() {
     return scope;
   }
@@ -1,11 +1,11 @@
 #ifndef NUKAC_PARSER_HPP
 #define NUKAC_PARSER_HPP
 
-#include <any>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <functional>
 
@@ -16,100 +16,303 @@ namespace nukac::parser {
     class Expression {
       public:
         virtual ~Expression() = default;
+
+        usize where_character = 0;
+        usize where_line = 0;
     };
-    
+
+    // bodies hold their expressions polymorphically, copies of a function
+    // share the nodes.
+    using ExpressionPtr = std::shared_ptr<Expression>;
+
     class NumberExpression: public Expression {
       public:
         NumberExpression(double val);
+        double getValue() const;
       private:
         double val;
     };
 
+    class QuotedExpression: public Expression {
+      public:
+        QuotedExpression(const std::string &val);
+        const std::string &getValue() const;
+      private:
+        std::string val;
+    };
+
+    class ReferenceExpression: public Expression {
+      public:
+        ReferenceExpression(const std::string &name);
+        const std::string &getName() const;
+      private:
+        std::string name;
+    };
+
     class TypeExpression: public Expression {
       public:
-        TypeExpression(const std::string &name, Expression &of_other_type);
+        TypeExpression(const std::string &name);
+        TypeExpression(const std::string &name, ExpressionPtr of_other_type);
 
-        std::string getName();
-        Expression &referencingType();
+        std::string getName() const;
+        ExpressionPtr referencingType();
       private:
         std::string name;
-        Expression &of_other_type;
+        ExpressionPtr of_other_type;
     };
 
     class VariableExpression: public Expression {
       public:
-        VariableExpression(std::string &name, ast::TypeExpression &type);
-        VariableExpression(std::string &name, 
-            ast::TypeExpression &type, 
-            std::vector<ast::Expression> &stored);
+        VariableExpression(const std::string &name, const ast::TypeExpression &type);
+        VariableExpression(const std::string &name,
+            const ast::TypeExpression &type,
+            ExpressionPtr stored);
 
-        void store(std::vector<Expression> stored);
-        std::vector<Expression> getStored();
+        void store(ExpressionPtr stored);
+        ExpressionPtr getStored() const;
+        const std::string &getName() const;
+        const TypeExpression &getType() const;
 
       private:
         std::string name;
-        TypeExpression &type;
-        std::vector<Expression> stored;
+        TypeExpression type;
+        ExpressionPtr stored;
     };
-    
+
+    class AssignExpression: public Expression {
+      public:
+        AssignExpression(const std::string &name, ExpressionPtr value);
+        const std::string &getName() const;
+        ExpressionPtr getValue() const;
+      private:
+        std::string name;
+        ExpressionPtr value;
+    };
+
     class BinaryExpression: public Expression {
       public:
         enum class Operand {
           oand,
           oor,
           oxor,
-          onot,
+          onot, // rhs only
           oplus,
           ominus,
           otimes,
           odivide,
           omodulo,
+          oless,
+          ogreater,
 
         };
-        BinaryExpression(Operand operand, 
-            Expression &lhs, Expression &rhs);
+        BinaryExpression(Operand operand,
+            ExpressionPtr lhs, ExpressionPtr rhs);
+        Operand getOperand() const;
+        ExpressionPtr getLhs() const;
+        ExpressionPtr getRhs() const;
       private:
         Operand operand;
-        Expression & lhs, rhs;
+        ExpressionPtr lhs, rhs;
+    };
+
+    class ReturnExpression: public Expression {
+      public:
+        ReturnExpression(ExpressionPtr value);
+        // null for a bare return;
+        ExpressionPtr getValue() const;
+      private:
+        ExpressionPtr value;
+    };
+
+    // try value, the error of value's error union goes to the caller.
+    class TryExpression: public Expression {
+      public:
+        TryExpression(ExpressionPtr value);
+        ExpressionPtr getValue() const;
+      private:
+        ExpressionPtr value;
+    };
+
+    // Set.Error
+    class ErrorExpression: public Expression {
+      public:
+        ErrorExpression(const std::string &set, const std::string &error);
+        const std::string &getSet() const;
+        const std::string &getError() const;
+      private:
+        std::string set;
+        std::string error;
+    };
+
+    // defer and errdefer, the body runs when the enclosing block is left,
+    // for errdefer only when that returns an error.
+    class DeferExpression: public Expression {
+      public:
+        DeferExpression(bool on_error, std::vector<ExpressionPtr> body);
+        bool onError() const;
+        const std::vector<ExpressionPtr> &getBody() const;
+      private:
+        bool on_error;
+        std::vector<ExpressionPtr> body;
+    };
+
+    // { statement* } inside a body, scopes its variables and defers.
+    class BlockExpression: public Expression {
+      public:
+        BlockExpression(std::vector<ExpressionPtr> body);
+        const std::vector<ExpressionPtr> &getBody() const;
+      private:
+        std::vector<ExpressionPtr> body;
+    };
+
+    struct Field {
+      enum class Access {
+        unknown,
+        hot,  // $hot
+        cold, // $cold
+      };
+
+      std::string name;
+      std::string type;
+      Access      access;
     };
 
     class StructExpression: public Expression {
       public:
-        StructExpression(const std::string &name, std::vector<Expression> contents);
+        StructExpression(const std::string &name, std::vector<ExpressionPtr> contents);
+        StructExpression(const std::string &name, std::vector<Field> fields,
+            bool pub, bool abi_fixed);
+
+        const std::string &getName() const;
+        const std::vector<Field> &getFields() const;
+        void setFields(std::vector<Field> fields);
+        // pub and $abi structs keep their declared field order.
+        bool isLayoutFixed() const;
       private:
         std::string name;
-        std::vector<Expression> contents;
+        std::vector<ExpressionPtr> contents;
+        std::vector<Field> fields;
+        bool pub = false;
+        bool abi_fixed = false;
     };
 
     class CallExpression: public Expression {
       public:
-        CallExpression(const std::string &callee, std::vector<Expression> args);
+        CallExpression(const std::string &callee, std::vector<ExpressionPtr> args);
+        CallExpression(const std::string &callee, std::vector<std::string> type_args,
+            std::vector<ExpressionPtr> args);
+        const std::string &getCallee() const;
+        const std::vector<std::string> &getTypeArgs() const;
+        const std::vector<ExpressionPtr> &getArgs() const;
       private:
         std::string callee;
-        std::vector<Expression> args;
+        std::vector<std::string> type_args;
+        std::vector<ExpressionPtr> args;
+    };
+
+    struct GenericParameter {
+      std::string name;
+      std::string bound; // trait name, empty if unbounded
     };
 
     class Prototype {
       public:
-        Prototype(const std::string &name, ast::TypeExpression &return_type, 
-            std::vector<ast::VariableExpression> args);
-        const std::string &getName();
-        const std::vector<ast::VariableExpression> getVariables;
+        Prototype(const std::string &name, const ast::TypeExpression &return_type,
+            std::vector<ast::VariableExpression> args,
+            usize where_character, usize where_line);
+        const std::string &getName() const;
+        const ast::TypeExpression &getReturnType() const;
+        const std::vector<ast::VariableExpression> &getVariables() const;
+
+        // Set!T, returns an error union of the set's tags and T.
+        void setErrorSet(const std::string &error_set);
+        const std::string &getErrorSet() const;
+        bool canFail() const;
+
+        void setGenerics(std::vector<GenericParameter> generics);
+        const std::vector<GenericParameter> &getGenerics() const;
+        bool isGeneric() const;
+
+        // the module that declares it, qualifies its generic instances.
+        void setModule(const std::string &module);
+        const std::string &getModule() const;
+
+        usize where_character;
+        usize where_line;
       private:
         std::string name;
-        ast::TypeExpression &return_type;
+        ast::TypeExpression return_type;
         std::vector<ast::VariableExpression> args;
+        std::vector<GenericParameter> generics;
+        std::string error_set;
+        std::string module;
     };
-    
+
     class Function {
       public:
-        Function(Prototype &proto, std::vector<Expression> body);
+        Function(Prototype proto, std::vector<ExpressionPtr> body);
+        // lazily parsed, only the token range of the body is known.
+        Function(Prototype proto, usize body_begin, usize body_end);
+        const Prototype &getPrototype() const;
+        const std::vector<ExpressionPtr> &getBody() const;
+
+        bool isParsed() const;
+        usize getBodyBegin() const;
+        usize getBodyEnd() const;
+        void setBody(std::vector<ExpressionPtr> body);
       private:
-        Prototype &proto;
-        std::vector<Expression> body;
+        Prototype proto;
+        std::vector<ExpressionPtr> body;
+
+        bool parsed;
+        usize body_begin;
+        usize body_end;
     };
 
-  } // ast 
+    // error tags are global, ziglike, so the same error has the same tag
+    // in every set and a propagated tag means the same thing to the 
+    // caller. 0 is reserved for success, errors count up from 1.
+    u16 errorTag(const std::string &error);
+
+    class ErrorSet {
+      public:
+        ErrorSet(const std::string &name, std::vector<std::string> errors);
+        const std::string &getName() const;
+        const std::vector<std::string> &getErrors() const;
+        // errorTag() of a member of the set.
+        u16 tagOf(const std::string &error) const;
+      private:
+        std::string name;
+        std::vector<std::string> errors;
+    };
+
+    class Trait {
+      public:
+        Trait(const std::string &name, std::vector<Prototype> prototypes);
+        const std::string &getName() const;
+        const std::vector<Prototype> &getPrototypes() const;
+      private:
+        std::string name;
+        std::vector<Prototype> prototypes;
+    };
+
+    class Implementation {
+      public:
+        Implementation(const std::string &trait, const std::string &type,
+            std::vector<Function> functions);
+        const std::string &getTrait() const;
+        const std::string &getType() const;
+        const std::vector<Function> &getFunctions() const;
+
+        usize where_character = 0;
+        usize where_line = 0;
+      private:
+        std::string trait;
+        std::string type;
+        std::vector<Function> functions;
+    };
+
+  } // ast
 
 
   class ParserException {
@@ -130,39 +333,75 @@ namespace nukac::parser {
 
   class Parser {
     public:
-      // optional macro
-      // PARSER_WHILE_CONDITIONAL
       Parser(lexer::Lexer &lexer);
-      Parser(lexer::Lexer &lexer,
-          std::unordered_map<std::string, ast::VariableExpression> variables,
-          std::vector<ast::Expression> expressions, 
-          std::vector<ast::Prototype> prototypes, 
-          std::vector<ast::Function> functions, 
-          std::unordered_map<std::string, ast::TypeExpression> parent_types,
-          Scope scope);
-
-      std::vector<ast::Expression> getExpressions();
+      // lazy_bodies only records the token range of every function body,
+      // see materialize().
+      Parser(lexer::Lexer &lexer, bool lazy_bodies);
+      // a file is a module, ziglike. module names what it declares, "root"
+      // by default.
+      Parser(lexer::Lexer &lexer, bool lazy_bodies, const std::string &module);
+
+      std::vector<ast::ExpressionPtr> getExpressions();
       std::vector<ast::Prototype> getPrototypes();
       std::vector<ast::Function> getFunctions();
+      std::vector<ast::Trait> getTraits();
+      std::vector<ast::Implementation> getImplementations();
+      std::vector<ast::StructExpression> getStructures();
+      std::vector<ast::ErrorSet> getErrorSets();
+      std::unordered_map<std::string, ast::TypeExpression> getTypes();
+      std::unordered_map<std::string, ast::VariableExpression> getVariables();
       const Scope getScope();
 
+      // parses the lazily recorded bodies of every function called name,
+      // no-op for the ones already there. returns those functions, empty if
+      // there's no such function.
+      std::vector<ast::Function> materialize(const std::string &name);
+
     private:
       lexer::Lexer &lexer;
       std::unordered_map<std::string, ast::VariableExpression> variables;
-      std::vector<ast::Expression> expressions;
+      std::vector<ast::ExpressionPtr> expressions;
       std::vector<ast::Prototype> prototypes;
       std::vector<ast::Function> functions;
+      std::vector<ast::Trait> traits;
+      std::vector<ast::Implementation> implementations;
+      std::vector<ast::StructExpression> structures;
+      std::vector<ast::ErrorSet> error_sets;
 
       std::unordered_map<std::string, ast::TypeExpression> scope_types;
+      std::unordered_set<usize> materializing; // by body_begin
+      std::vector<lexer::Literal> compile_time_calls; // $name, see parserPDirective
 
       inline void parserInternal();
+      void parserCompileTimeCalls();
+      inline void parserPDirective(lexer::Literal dollar);
       inline void parserPFunction();
-      inline void parserPStructure();
-      inline void parserPReturn();
-      inline void parserPVariable(std::string name);
-      inline void parserPVariableAssign(std::string name);
+      inline std::vector<ast::ExpressionPtr> parserPBody();
+      inline ast::ExpressionPtr parserPStatement();
+      inline void parserPStructure(bool pub, bool abi_fixed);
+      inline std::vector<ast::GenericParameter> parserPGenerics();
+      inline void parserPTrait();
+      inline void parserPErrorSet();
+      inline void parserPImplements();
+      inline ast::ExpressionPtr parserPReturn(lexer::Literal literal);
+      inline ast::ExpressionPtr parserPDefer(lexer::Literal literal);
+      inline ast::ExpressionPtr parserPVariable(lexer::Literal name);
+      inline ast::ExpressionPtr parserPVariableAssign(lexer::Literal name);
+
+      inline ast::ExpressionPtr parserPValue();
+
+      // precedence climbing, lowest first
+      inline ast::ExpressionPtr parserPExpression();
+      inline ast::ExpressionPtr parserPAnd();
+      inline ast::ExpressionPtr parserPComparison();
+      inline ast::ExpressionPtr parserPAdditive();
+      inline ast::ExpressionPtr parserPMultiplicative();
+      inline ast::ExpressionPtr parserPUnary();
+      inline ast::ExpressionPtr parserPPrimary();
 
       Scope scope;
+      bool lazy_bodies = false;
+      std::string module;
   };
 
 } // nukac::parser
@@ -0,0 +1,669 @@
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+#include "mono.hpp"
+#include "sema.hpp"
+
+namespace nukac::sema {
+  using namespace nukac::parser;
+
+  // functions handed to a worker per fetch, keeps the shared counter
+  // off the hot path for modules with thousands of small functions.
+  constexpr usize functions_per_batch = 16;
+
+  // literals get their type from where they are used.
+  constexpr std::string_view number_type = "{number}";
+  constexpr std::string_view quoted_type = "{string}";
+  // stands for the implementing type in a trait's prototypes.
+  constexpr std::string_view self_type = "Self";
+
+  constexpr std::string_view numeric_types[] = {
+    "u8", "u16", "u32", "u64", "usize",
+    "i8", "i16", "i32", "i64", "size",
+    "f32", "f64",
+  };
+
+  struct Analyzer::Context {
+    const ast::Prototype                         &proto;
+    std::unordered_map<std::string, std::string> generics; // to its bound, empty if none
+    std::unordered_map<std::string, std::string> names;
+    std::vector<Diagnostic>                      &out;
+
+    void report(const ast::Expression *at, std::string message) {
+      const bool positioned = at && at->where_line != 0;
+      out.push_back({
+          .where_character = positioned ? at->where_character : proto.where_character,
+          .where_line = positioned ? at->where_line : proto.where_line,
+          .message = std::format("{}: {}", proto.getName(), message)
+      });
+    }
+
+    bool numeric(const std::string &type) {
+      return generics.contains(type) || 
+        std::find(std::begin(numeric_types), std::end(numeric_types), type) != std::end(numeric_types);
+    }
+
+    // an empty type was already reported, don't pile on.
+    bool compatible(const std::string &expected, const std::string &actual) {
+      if(expected.empty() || actual.empty()) return true;
+      if(generics.contains(expected) || generics.contains(actual)) return true;
+      if(actual == number_type) return numeric(expected);
+      if(expected == number_type) return numeric(actual);
+      return expected == actual;
+    }
+  };
+
+  // self replaces Self in a, for a trait's prototype against its implementation.
+  static bool semaSameSignature(const ast::Prototype &a, const ast::Prototype &b, 
+      const std::string &self = "") {
+    auto type = [&](const std::string &name) {
+      return !self.empty() && name == self_type ? self : name;
+    };
+    if(type(a.getReturnType().getName()) != b.getReturnType().getName()) return false;
+    if(a.getErrorSet() != b.getErrorSet()) return false;
+    if(a.getGenerics().size() != b.getGenerics().size()) return false;
+    if(a.getVariables().size() != b.getVariables().size()) return false;
+    for(usize i = 0; i < a.getVariables().size(); i++)
+      if(type(a.getVariables()[i].getType().getName()) != b.getVariables()[i].getType().getName()) 
+        return false;
+    return true;
+  }
+
+  std::ostream &operator<<(std::ostream &output, const Diagnostic &diagnostic) {
+    output << std::format("{}:{}: {}", diagnostic.where_line, 
+        diagnostic.where_character, diagnostic.message);
+    return output;
+  }
+
+  Analyzer::Analyzer(parser::Parser &parser):
+    declared(parser.getPrototypes()),
+    functions(parser.getFunctions()),
+    types(parser.getTypes()),
+    globals(parser.getVariables()) {
+    for(ast::Trait &trait: parser.getTraits()) {
+      const std::string name = trait.getName();
+      traits.insert_or_assign(name, std::move(trait));
+    }
+    for(ast::ErrorSet &error_set: parser.getErrorSets()) {
+      const std::string name = error_set.getName();
+      error_sets.insert_or_assign(name, std::move(error_set));
+    }
+
+    semaMaterialize(parser);
+    semaCollect();
+    semaImplementations(parser.getImplementations());
+    semaCheckFunctions();
+
+    std::stable_sort(diagnostics.begin(), diagnostics.end(), 
+        [](const Diagnostic &a, const Diagnostic &b) {
+          if(a.where_line != b.where_line) return a.where_line < b.where_line;
+          return a.where_character < b.where_character;
+        });
+  }
+
+  // the try a statement stores or evaluates, null if none.
+  static std::shared_ptr<ast::TryExpression> semaTried(const ast::ExpressionPtr &statement) {
+    if(auto variable = std::dynamic_pointer_cast<ast::VariableExpression>(statement))
+      return std::dynamic_pointer_cast<ast::TryExpression>(variable->getStored());
+    if(auto assign = std::dynamic_pointer_cast<ast::AssignExpression>(statement))
+      return std::dynamic_pointer_cast<ast::TryExpression>(assign->getValue());
+    return std::dynamic_pointer_cast<ast::TryExpression>(statement);
+  }
+
+  // what lower::Lowerer can copy to every exit of a block.
+  static bool semaDeferrable(const ast::ExpressionPtr &statement) {
+    if(auto block = std::dynamic_pointer_cast<ast::BlockExpression>(statement))
+      return std::all_of(block->getBody().begin(), block->getBody().end(), semaDeferrable);
+    return !std::dynamic_pointer_cast<ast::ReturnExpression>(statement) &&
+      !std::dynamic_pointer_cast<ast::DeferExpression>(statement) && !semaTried(statement);
+  }
+
+  static void semaCalls(const ast::ExpressionPtr &expression, 
+      std::vector<const ast::CallExpression *> &out) {
+    if(auto call = std::dynamic_pointer_cast<ast::CallExpression>(expression)) {
+      out.push_back(call.get());
+      for(const ast::ExpressionPtr &arg: call->getArgs()) semaCalls(arg, out);
+    } else if(auto binary = std::dynamic_pointer_cast<ast::BinaryExpression>(expression)) {
+      semaCalls(binary->getLhs(), out);
+      semaCalls(binary->getRhs(), out);
+    } else if(auto variable = std::dynamic_pointer_cast<ast::VariableExpression>(expression)) {
+      semaCalls(variable->getStored(), out);
+    } else if(auto assign = std::dynamic_pointer_cast<ast::AssignExpression>(expression)) {
+      semaCalls(assign->getValue(), out);
+    } else if(auto ret = std::dynamic_pointer_cast<ast::ReturnExpression>(expression)) {
+      semaCalls(ret->getValue(), out);
+    } else if(auto tried = std::dynamic_pointer_cast<ast::TryExpression>(expression)) {
+      semaCalls(tried->getValue(), out);
+    } else if(auto deferred = std::dynamic_pointer_cast<ast::DeferExpression>(expression)) {
+      for(const ast::ExpressionPtr &statement: deferred->getBody()) semaCalls(statement, out);
+    } else if(auto block = std::dynamic_pointer_cast<ast::BlockExpression>(expression)) {
+      for(const ast::ExpressionPtr &statement: block->getBody()) semaCalls(statement, out);
+    }
+  }
+
+  void Analyzer::semaMaterialize(parser::Parser &parser) {
+    const bool lazy = std::any_of(functions.begin(), functions.end(), 
+        [](const ast::Function &function) { return !function.isParsed(); });
+    if(!lazy) return;
+
+    // only bodies reachable from main get parsed and checked, without a
+    // main everything is reachable.
+    std::vector<std::string> pending;
+    for(const ast::Function &function: functions)
+      if(function.getPrototype().getName() == "main") pending = { "main" };
+    if(pending.empty())
+      for(const ast::Function &function: functions) pending.push_back(function.getPrototype().getName());
+
+    std::unordered_set<std::string> reached;
+    functions.clear();
+    while(!pending.empty()) {
+      const std::string name = std::move(pending.back());
+      pending.pop_back();
+      if(!reached.insert(name).second) continue;
+
+      for(ast::Function &function: parser.materialize(name)) {
+        std::vector<const ast::CallExpression *> calls;
+        for(const ast::ExpressionPtr &statement: function.getBody()) semaCalls(statement, calls);
+        for(const ast::CallExpression *call: calls) pending.push_back(call->getCallee());
+        functions.push_back(std::move(function));
+      }
+    }
+
+    // keep declaration order, diagnostics are merged in it.
+    std::stable_sort(functions.begin(), functions.end(), 
+        [](const ast::Function &a, const ast::Function &b) {
+          return a.getPrototype().where_line < b.getPrototype().where_line;
+        });
+  }
+
+  void Analyzer::semaCollect() {
+    // a forward declaration and its definition both land in declared, only
+    // differing signatures are a problem. two bodies are caught below.
+    for(usize i = 0; i < declared.size(); i++) {
+      const ast::Prototype &proto = declared[i];
+      auto [first, inserted] = prototypes.try_emplace(proto.getName(), i);
+      if(!inserted && !semaSameSignature(declared[first->second], proto)) {
+        diagnostics.push_back({
+            .where_character = proto.where_character,
+            .where_line = proto.where_line,
+            .message = std::format("Conflicting declaration of function {}.", proto.getName())
+        });
+      }
+
+      for(const ast::GenericParameter &generic: proto.getGenerics()) {
+        if(!generic.bound.empty() && !traits.contains(generic.bound)) {
+          diagnostics.push_back({
+              .where_character = proto.where_character,
+              .where_line = proto.where_line,
+              .message = std::format("{}: Unknown trait {} bounding {}.", 
+                  proto.getName(), generic.bound, generic.name)
+          });
+        }
+      }
+    }
+
+    for(usize i = 0; i < functions.size(); i++) {
+      const ast::Prototype &proto = functions[i].getPrototype();
+      if(!bodies.try_emplace(proto.getName(), i).second) {
+        diagnostics.push_back({
+            .where_character = proto.where_character,
+            .where_line = proto.where_line,
+            .message = std::format("Redefinition of function {}.", proto.getName())
+        });
+      }
+    }
+
+    // bodies report theirs in semaCheckFunction.
+    for(const ast::Prototype &proto: declared) {
+      if(proto.canFail() && !error_sets.contains(proto.getErrorSet()) && !bodies.contains(proto.getName())) {
+        diagnostics.push_back({
+            .where_character = proto.where_character,
+            .where_line = proto.where_line,
+            .message = std::format("{}: Unknown error set {}.", proto.getName(), proto.getErrorSet())
+        });
+      }
+    }
+
+    for(const auto &[name, global]: globals) {
+      if(!types.contains(global.getType().getName())) {
+        diagnostics.push_back({
+            .where_character = global.where_character,
+            .where_line = global.where_line,
+            .message = std::format("Unknown type {} of variable {}.", global.getType().getName(), name)
+        });
+      }
+    }
+  }
+
+  void Analyzer::semaImplementations(const std::vector<ast::Implementation> &implementations) {
+    for(const ast::Implementation &implementation: implementations) {
+      auto report = [&](usize character, usize line, std::string message) {
+        diagnostics.push_back({
+            .where_character = character,
+            .where_line = line,
+            .message = std::format("{} for {}: {}", implementation.getTrait(), 
+                implementation.getType(), message)
+        });
+      };
+
+      const std::string key = std::format("{}:{}", implementation.getTrait(), implementation.getType());
+      if(!implemented.insert(key).second)
+        report(implementation.where_character, implementation.where_line, "Implemented twice.");
+      if(!types.contains(implementation.getType()))
+        report(implementation.where_character, implementation.where_line, "Unknown type.");
+
+      // the bodies are checked like any other function.
+      for(const ast::Function &function: implementation.getFunctions())
+        functions.push_back(function);
+
+      auto trait = traits.find(implementation.getTrait());
+      if(trait == traits.end()) {
+        report(implementation.where_character, implementation.where_line, "Unknown trait.");
+        continue;
+      }
+
+      const std::vector<ast::Prototype> &required = trait->second.getPrototypes();
+      for(const ast::Function &function: implementation.getFunctions()) {
+        const ast::Prototype &proto = function.getPrototype();
+        auto wanted = std::find_if(required.begin(), required.end(), 
+            [&](const ast::Prototype &p) { return p.getName() == proto.getName(); });
+        if(wanted == required.end())
+          report(proto.where_character, proto.where_line, 
+              std::format("{} isn't part of the trait.", proto.getName()));
+        else if(!semaSameSignature(*wanted, proto, implementation.getType()))
+          report(proto.where_character, proto.where_line, 
+              std::format("{} doesn't match the trait's declaration.", proto.getName()));
+      }
+
+      for(const ast::Prototype &proto: required) {
+        const std::vector<ast::Function> &provided = implementation.getFunctions();
+        if(std::none_of(provided.begin(), provided.end(), 
+              [&](const ast::Function &f) { return f.getPrototype().getName() == proto.getName(); }))
+          report(implementation.where_character, implementation.where_line, 
+              std::format("Missing {}.", proto.getName()));
+      }
+    }
+  }
+
+  void Analyzer::semaCheckFunctions() {
+    // one slot per function, so the merge below is in declaration order
+    // no matter which worker finished first.
+    std::vector<std::vector<Diagnostic>> per_function(functions.size());
+    std::atomic<usize> next_function = 0;
+
+    auto worker = [&]() {
+      while(true) {
+        const usize begin = next_function.fetch_add(functions_per_batch, std::memory_order_relaxed);
+        if(begin >= functions.size()) return;
+        const usize end = std::min(begin + functions_per_batch, functions.size());
+        for(usize i = begin; i < end; i++)
+          semaCheckFunction(functions[i], per_function[i]);
+      }
+    };
+
+    const usize batches = (functions.size() + functions_per_batch - 1) / functions_per_batch;
+    const usize workers = std::min<usize>(std::max(1u, std::thread::hardware_concurrency()), batches);
+    {
+      std::vector<std::jthread> pool;
+      for(usize i = 1; i < workers; i++) pool.emplace_back(worker);
+      worker();
+    }
+
+    for(std::vector<Diagnostic> &found: per_function)
+      diagnostics.insert(diagnostics.end(), 
+          std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+  }
+
+  void Analyzer::semaCheckFunction(const ast::Function &function, 
+      std::vector<Diagnostic> &out) const {
+    const ast::Prototype &proto = function.getPrototype();
+    Context context{ .proto = proto, .out = out };
+    for(const ast::GenericParameter &generic: proto.getGenerics())
+      context.generics.emplace(generic.name, generic.bound);
+    auto known = [&](const std::string &type) {
+      return types.contains(type) || context.generics.contains(type);
+    };
+
+    if(!known(proto.getReturnType().getName()))
+      context.report(nullptr, std::format("Unknown return type {}.", proto.getReturnType().getName()));
+    if(proto.canFail() && !error_sets.contains(proto.getErrorSet()))
+      context.report(nullptr, std::format("Unknown error set {}.", proto.getErrorSet()));
+
+    for(const ast::VariableExpression &arg: proto.getVariables()) {
+      if(!known(arg.getType().getName()))
+        context.report(nullptr, std::format("Unknown type {} of argument {}.", 
+              arg.getType().getName(), arg.getName()));
+      if(!context.names.try_emplace(arg.getName(), arg.getType().getName()).second)
+        context.report(nullptr, std::format("Duplicate argument {}.", arg.getName()));
+    }
+
+    for(const ast::ExpressionPtr &statement: function.getBody())
+      semaStatement(context, statement);
+  }
+
+  void Analyzer::semaStatement(Context &context, const ast::ExpressionPtr &statement) const {
+    if(auto variable = std::dynamic_pointer_cast<ast::VariableExpression>(statement)) {
+      const std::string type = variable->getType().getName();
+      if(!types.contains(type) && !context.generics.contains(type))
+        context.report(statement.get(), std::format("Unknown type {} of variable {}.", type, variable->getName()));
+
+      if(variable->getStored()) {
+        const std::string stored = semaType(context, variable->getStored());
+        if(!context.compatible(type, stored))
+          context.report(statement.get(), std::format("Can't initialize {} of type {} with {}.", 
+                variable->getName(), type, stored));
+      }
+
+      if(!context.names.try_emplace(variable->getName(), type).second)
+        context.report(statement.get(), std::format("{} is already declared.", variable->getName()));
+    } else if(auto assign = std::dynamic_pointer_cast<ast::AssignExpression>(statement)) {
+      std::string type;
+      if(auto local = context.names.find(assign->getName()); local != context.names.end())
+        type = local->second;
+      else if(auto global = globals.find(assign->getName()); global != globals.end())
+        type = global->second.getType().getName();
+      else context.report(statement.get(), std::format("Unknown name {}.", assign->getName()));
+
+      const std::string value = semaType(context, assign->getValue());
+      if(!context.compatible(type, value))
+        context.report(statement.get(), std::format("Can't assign {} to {} of type {}.", 
+              value, assign->getName(), type));
+    } else if(auto ret = std::dynamic_pointer_cast<ast::ReturnExpression>(statement)) {
+      const std::string expected = context.proto.getReturnType().getName();
+      if(auto error = std::dynamic_pointer_cast<ast::ErrorExpression>(ret->getValue())) {
+        if(semaType(context, ret->getValue()).empty()) return;
+        if(!context.proto.canFail())
+          context.report(statement.get(), std::format("Returning {}.{} from a function that can't fail.", 
+                error->getSet(), error->getError()));
+        else if(error->getSet() != context.proto.getErrorSet() && 
+            !semaInSet(context.proto.getErrorSet(), error->getError()))
+          context.report(statement.get(), std::format("{} isn't part of {}.", 
+                error->getError(), context.proto.getErrorSet()));
+      } else if(!ret->getValue()) {
+        if(expected != "void") context.report(statement.get(), "Missing return value.");
+      } else if(expected == "void") {
+        context.report(statement.get(), "Returning a value from a void function.");
+      } else {
+        const std::string value = semaType(context, ret->getValue());
+        if(!context.compatible(expected, value))
+          context.report(statement.get(), std::format("Returning {} from a function returning {}.", 
+                value, expected));
+      }
+    } else if(auto deferred = std::dynamic_pointer_cast<ast::DeferExpression>(statement)) {
+      // runs at the end of the block, its names don't outlive it.
+      const std::unordered_map<std::string, std::string> names = context.names;
+      for(const ast::ExpressionPtr &body: deferred->getBody()) {
+        if(!semaDeferrable(body))
+          context.report(body.get(), "Only expressions can be deferred, no returns, try or nested defers.");
+        semaStatement(context, body);
+      }
+      context.names = names;
+    } else if(auto block = std::dynamic_pointer_cast<ast::BlockExpression>(statement)) {
+      const std::unordered_map<std::string, std::string> names = context.names;
+      for(const ast::ExpressionPtr &body: block->getBody()) semaStatement(context, body);
+      context.names = names;
+    } else {
+      const std::string type = semaType(context, statement);
+      if(type.contains('!'))
+        context.report(statement.get(), std::format("The error of {} is ignored, use try.", type));
+    }
+  }
+
+  // unknown sets were reported where they're named, anything goes there.
+  bool Analyzer::semaInSet(const std::string &set, const std::string &error) const {
+    auto found = error_sets.find(set);
+    if(found == error_sets.end()) return true;
+    const std::vector<std::string> &errors = found->second.getErrors();
+    return std::find(errors.begin(), errors.end(), error) != errors.end();
+  }
+
+  std::string Analyzer::semaType(Context &context, const ast::ExpressionPtr &expression) const {
+    using Operand = ast::BinaryExpression::Operand;
+
+    if(std::dynamic_pointer_cast<ast::NumberExpression>(expression)) {
+      return std::string(number_type);
+    } else if(std::dynamic_pointer_cast<ast::QuotedExpression>(expression)) {
+      return std::string(quoted_type);
+    } else if(auto reference = std::dynamic_pointer_cast<ast::ReferenceExpression>(expression)) {
+      if(auto local = context.names.find(reference->getName()); local != context.names.end())
+        return local->second;
+      if(auto global = globals.find(reference->getName()); global != globals.end())
+        return global->second.getType().getName();
+      context.report(expression.get(), std::format("Unknown name {}.", reference->getName()));
+      return "";
+    } else if(auto call = std::dynamic_pointer_cast<ast::CallExpression>(expression)) {
+      return semaCall(context, *call);
+    } else if(auto tried = std::dynamic_pointer_cast<ast::TryExpression>(expression)) {
+      const std::string type = semaType(context, tried->getValue());
+      if(!context.proto.canFail())
+        context.report(expression.get(), "try in a function that can't fail.");
+      const usize bang = type.find('!');
+      if(bang == std::string::npos) {
+        if(!type.empty()) context.report(expression.get(), std::format("try on {}, which can't fail.", type));
+        return type;
+      }
+
+      // tags are global, but the caller only expects its own set.
+      const std::string set = type.substr(0, bang);
+      if(auto found = error_sets.find(set); context.proto.canFail() && found != error_sets.end())
+        for(const std::string &error: found->second.getErrors())
+          if(!semaInSet(context.proto.getErrorSet(), error))
+            context.report(expression.get(), std::format("try passes on {}, which isn't part of {}.", 
+                  error, context.proto.getErrorSet()));
+      return type.substr(bang + 1);
+    } else if(auto error = std::dynamic_pointer_cast<ast::ErrorExpression>(expression)) {
+      if(!error_sets.contains(error->getSet())) {
+        context.report(expression.get(), std::format("Unknown error set {}.", error->getSet()));
+        return "";
+      }
+      if(!semaInSet(error->getSet(), error->getError()))
+        context.report(expression.get(), std::format("{} isn't part of {}.", error->getError(), error->getSet()));
+      return error->getSet();
+    } else if(auto binary = std::dynamic_pointer_cast<ast::BinaryExpression>(expression)) {
+      const std::string rhs = semaType(context, binary->getRhs());
+      if(binary->getOperand() == Operand::onot) {
+        if(!context.compatible("bool", rhs))
+          context.report(expression.get(), std::format("not applied to {}.", rhs));
+        return "bool";
+      }
+
+      const std::string lhs = semaType(context, binary->getLhs());
+      switch(binary->getOperand()) {
+        case Operand::oand: case Operand::oor:
+          if(!context.compatible("bool", lhs) || !context.compatible("bool", rhs))
+            context.report(expression.get(), std::format("Logical operator on {} and {}.", lhs, rhs));
+          return "bool";
+        case Operand::oless: case Operand::ogreater:
+          if(!context.compatible(lhs, rhs))
+            context.report(expression.get(), std::format("Comparing {} with {}.", lhs, rhs));
+          return "bool";
+        default:
+          if(!context.compatible(lhs, rhs))
+            context.report(expression.get(), std::format("Mismatched operand types {} and {}.", lhs, rhs));
+          else if(!lhs.empty() && lhs != number_type && !context.numeric(lhs))
+            context.report(expression.get(), std::format("Arithmetic on non-numeric type {}.", lhs));
+          return lhs == number_type ? rhs : lhs;
+      }
+    }
+
+    return "";
+  }
+
+  const ast::Prototype *Analyzer::semaBoundMethod(Context &context, const ast::CallExpression &call,
+      const std::vector<std::string> &args, std::string &bounded) const {
+    // every bound trait declaring the callee, narrowed to the ones whose
+    // Self parameters get that generic's values.
+    std::vector<std::pair<const ast::Prototype *, std::string>> found;
+    for(const ast::GenericParameter &generic: context.proto.getGenerics()) {
+      auto trait = traits.find(generic.bound);
+      if(trait == traits.end()) continue;
+      for(const ast::Prototype &method: trait->second.getPrototypes())
+        if(method.getName() == call.getCallee()) found.push_back({ &method, generic.name });
+    }
+    if(found.empty()) return nullptr;
+
+    std::vector<std::pair<const ast::Prototype *, std::string>> matching;
+    for(const auto &[method, generic]: found) {
+      const std::vector<ast::VariableExpression> &parameters = method->getVariables();
+      bool matches = parameters.size() == args.size();
+      for(usize i = 0; matches && i < args.size(); i++)
+        matches = parameters[i].getType().getName() != self_type || args[i] == generic;
+      if(matches) matching.push_back({ method, generic });
+    }
+    if(matching.empty()) matching = found;
+
+    if(matching.size() > 1)
+      context.report(&call, std::format("Call to {} is ambiguous between the bounds of {} and {}.", 
+            call.getCallee(), matching[0].second, matching[1].second));
+    bounded = matching[0].second;
+    return matching[0].first;
+  }
+
+  std::string Analyzer::semaCall(Context &context, const ast::CallExpression &call) const {
+    std::vector<std::string> args;
+    for(const ast::ExpressionPtr &arg: call.getArgs()) args.push_back(semaType(context, arg));
+
+    // a generic's bound traits come first, their functions take Self as
+    // the bounded parameter.
+    std::unordered_map<std::string, std::string> substitution;
+    std::string bounded;
+    const ast::Prototype *method = semaBoundMethod(context, call, args, bounded);
+    if(method) substitution[std::string(self_type)] = bounded;
+
+    auto found = prototypes.find(call.getCallee());
+    if(!method && found == prototypes.end()) {
+      context.report(&call, std::format("Call to undeclared function {}.", call.getCallee()));
+      return "";
+    }
+
+    const ast::Prototype &callee = method ? *method : declared[found->second];
+    auto substituted = [&](const std::string &type) {
+      auto found = substitution.find(type);
+      return found == substitution.end() ? type : found->second;
+    };
+    // a fallible call is a Set!T until try takes the T out.
+    auto returned = [&]() {
+      const std::string type = substituted(callee.getReturnType().getName());
+      return callee.canFail() ? std::format("{}!{}", callee.getErrorSet(), type) : type;
+    };
+
+    const std::vector<ast::VariableExpression> &parameters = callee.getVariables();
+    if(parameters.size() != args.size()) {
+      context.report(&call, std::format("Function {} takes {} arguments, {} given.", 
+            call.getCallee(), parameters.size(), args.size()));
+      return returned();
+    }
+
+    // generic parameters are replaced by the call's type arguments, if
+    // there are as many as the callee wants.
+    if(callee.isGeneric()) {
+      semaInstantiate(context, callee, call);
+      if(callee.getGenerics().size() == call.getTypeArgs().size())
+        for(usize i = 0; i < call.getTypeArgs().size(); i++)
+          substitution[callee.getGenerics()[i].name] = call.getTypeArgs()[i];
+    }
+
+    for(usize i = 0; i < args.size(); i++) {
+      const std::string expected = substituted(parameters[i].getType().getName());
+      if(!context.compatible(expected, args[i]))
+        context.report(call.getArgs()[i].get(), std::format("Argument {} of {} is {}, expected {}.", 
+              parameters[i].getName(), call.getCallee(), args[i], expected));
+    }
+    return returned();
+  }
+
+  void Analyzer::semaInstantiate(Context &context, const ast::Prototype &generic, 
+      const ast::CallExpression &call) const {
+    const std::vector<ast::GenericParameter> &parameters = generic.getGenerics();
+    const std::vector<std::string> &arguments = call.getTypeArgs();
+    if(parameters.size() != arguments.size()) {
+      context.report(&call, std::format("{} takes {} type arguments, {} given.", 
+            generic.getName(), parameters.size(), arguments.size()));
+      return;
+    }
+
+    // bounds are checked at every call, the diagnostics belong to it. 
+    // the caller's own generics satisfy a bound through theirs.
+    bool satisfied = true;
+    bool concrete = true;
+    for(usize i = 0; i < parameters.size(); i++) {
+      const std::string &bound = parameters[i].bound;
+      if(auto own = context.generics.find(arguments[i]); own != context.generics.end()) {
+        concrete = false;
+        if(!bound.empty() && own->second != bound) {
+          context.report(&call, std::format("{} isn't bound by {}.", arguments[i], bound));
+          satisfied = false;
+        }
+      } else if(!types.contains(arguments[i])) {
+        context.report(&call, std::format("Unknown type argument {}.", arguments[i]));
+        satisfied = false;
+      } else if(!bound.empty() && !implemented.contains(std::format("{}:{}", bound, arguments[i]))) {
+        context.report(&call, std::format("{} doesn't implement {}.", arguments[i], bound));
+        satisfied = false;
+      }
+    }
+
+    // with the caller's generics in it, the instance is only known once 
+    // the caller is instantiated, semaMonomorphize gets there from it.
+    if(satisfied && concrete) semaMonomorphize(generic, arguments);
+  }
+
+  void Analyzer::semaMonomorphize(const ast::Prototype &generic, 
+      const std::vector<std::string> &arguments) const {
+    // an instance's calls to other generics are instances too. they're 
+    // followed once, for the caller that created the instance, which is 
+    // also what ends recursive generics.
+    std::vector<std::pair<const ast::Prototype *, std::vector<std::string>>> pending{{ &generic, arguments }};
+    while(!pending.empty()) {
+      auto [proto, instance_types] = std::move(pending.back());
+      pending.pop_back();
+
+      std::vector<mono::TypeId> ids;
+      for(const std::string &argument: instance_types)
+        ids.push_back(mono::cache().getTypes().intern(argument));
+      bool created = false;
+      // keyed by the module declaring the generic, not the one using it.
+      mono::cache().instantiate(std::format("{}::{}", proto->getModule(), proto->getName()), 
+          std::move(ids), [&](const mono::Instance &) { created = true; });
+      if(!created) continue;
+
+      auto body = bodies.find(proto->getName());
+      if(body == bodies.end()) continue;
+
+      std::unordered_map<std::string, std::string> substitution;
+      for(usize i = 0; i < instance_types.size(); i++) substitution[proto->getGenerics()[i].name] = instance_types[i];
+
+      std::vector<const ast::CallExpression *> calls;
+      for(const ast::ExpressionPtr &statement: functions[body->second].getBody()) semaCalls(statement, calls);
+      for(const ast::CallExpression *call: calls) {
+        auto callee = prototypes.find(call->getCallee());
+        if(callee == prototypes.end()) continue;
+        const ast::Prototype &next = declared[callee->second];
+        if(!next.isGeneric() || next.getGenerics().size() != call->getTypeArgs().size()) continue;
+
+        std::vector<std::string> next_types;
+        for(const std::string &argument: call->getTypeArgs()) {
+          auto replaced = substitution.find(argument);
+          next_types.push_back(replaced == substitution.end() ? argument : replaced->second);
+        }
+        // a bad argument was already reported at the call.
+        if(std::all_of(next_types.begin(), next_types.end(), 
+              [&](const std::string &type) { return types.contains(type); }))
+          pending.push_back({ &next, std::move(next_types) });
+      }
+    }
+  }
+
+  std::vector<Diagnostic> Analyzer::getDiagnostics() {
+    return diagnostics;
+  }
+
+  bool Analyzer::hasErrors() {
+    return !diagnostics.empty();
+  }
+
+} // nukac::sema
@@ -0,0 +1,74 @@
+#ifndef NUKAC_SEMA_HPP
+#define NUKAC_SEMA_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "helper.hpp"
+#include "parser.hpp"
+
+namespace nukac::sema {
+  struct Diagnostic {
+    usize       where_character;
+    usize       where_line;
+    std::string message;
+  };
+
+  std::ostream &operator<<(std::ostream &output, const Diagnostic &diagnostic);
+
+  class Analyzer {
+    public:
+      // takes its own copy of everything the parser produced. prototypes 
+      // and types are collected once up front, every function body is 
+      // then checked on its own worker against that read-only view.
+      // with a lazy parser only the bodies reachable from main are parsed,
+      // serially since that drives the parser's lexer, and checked.
+      // generic instances go to mono::cache(), qualified by the module
+      // that declares the generic.
+      Analyzer(parser::Parser &parser);
+
+      std::vector<Diagnostic> getDiagnostics();
+      bool hasErrors();
+
+    private:
+      struct Context;
+
+      std::vector<parser::ast::Prototype> declared;
+      std::vector<parser::ast::Function> functions;
+      std::unordered_map<std::string, parser::ast::TypeExpression> types;
+      std::unordered_map<std::string, parser::ast::VariableExpression> globals;
+      std::unordered_map<std::string, parser::ast::Trait> traits;
+      std::unordered_map<std::string, parser::ast::ErrorSet> error_sets;
+
+      std::unordered_map<std::string, usize> prototypes; // into declared
+      std::unordered_map<std::string, usize> bodies; // into functions
+      std::unordered_set<std::string> implemented; // "trait:type"
+
+      std::vector<Diagnostic> diagnostics;
+
+      void semaMaterialize(parser::Parser &parser);
+      void semaCollect();
+      void semaImplementations(const std::vector<parser::ast::Implementation> &implementations);
+      void semaCheckFunctions();
+      void semaCheckFunction(const parser::ast::Function &function, 
+          std::vector<Diagnostic> &out) const;
+      void semaStatement(Context &context, const parser::ast::ExpressionPtr &statement) const;
+      bool semaInSet(const std::string &set, const std::string &error) const;
+      std::string semaType(Context &context, const parser::ast::ExpressionPtr &expression) const;
+      std::string semaCall(Context &context, const parser::ast::CallExpression &call) const;
+      // the bound trait's function a call inside a generic resolves to,
+      // bounded is the generic standing for Self. null if none.
+      const parser::ast::Prototype *semaBoundMethod(Context &context, 
+          const parser::ast::CallExpression &call, const std::vector<std::string> &args, 
+          std::string &bounded) const;
+      void semaInstantiate(Context &context, const parser::ast::Prototype &generic, 
+          const parser::ast::CallExpression &call) const;
+      void semaMonomorphize(const parser::ast::Prototype &generic, 
+          const std::vector<std::string> &arguments) const;
+  }; // Analyzer
+
+} // nukac::sema
+
+#endif // NUKAC_SEMA_HPP
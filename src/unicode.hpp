@@ -0,0 +1,21 @@
+#ifndef NUKAC_UNICODE_HPP
+#define NUKAC_UNICODE_HPP
+
+#include <string_view>
+
+#include "helper.hpp"
+
+namespace nukac::unicode {
+  // checks the whole buffer, at is set to the first offending byte.
+  bool validUtf8(std::string_view s, usize &at) noexcept;
+
+  // decodes the codepoint starting at s[at] and moves at past it,
+  // s has to be valid UTF-8.
+  u32 decode(std::string_view s, usize &at) noexcept;
+
+  // only meaningful above ASCII, the lexer handles that range itself.
+  bool isXidStart(u32 codepoint) noexcept;
+  bool isXidContinue(u32 codepoint) noexcept;
+} // nukac::unicode
+
+#endif // NUKAC_UNICODE_HPP
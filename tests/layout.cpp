@@ -0,0 +1,194 @@
+// field order, offsets and padding out of nukac::layout::Layouter.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../src/layout.hpp"
+
+namespace {
+  using namespace nukac;
+  using parser::ast::Field;
+  using parser::ast::StructExpression;
+  using Access = Field::Access;
+
+  int failures = 0;
+
+  void check(bool ok, const std::string &what) {
+    if(ok) return;
+    std::printf("FAIL: %s\n", what.c_str());
+    failures++;
+  }
+
+  const layout::StructLayout &find(const std::vector<layout::StructLayout> &layouts, 
+      const std::string &name) {
+    for(const layout::StructLayout &layout: layouts)
+      if(layout.name == name) return layout;
+    std::printf("FAIL: no layout for %s\n", name.c_str());
+    std::exit(1);
+  }
+
+  // "name@offset ..." for the fields in order.
+  std::string placed(const layout::StructLayout &layout) {
+    std::string out;
+    for(const layout::FieldLayout &field: layout.fields)
+      out += (out.empty() ? "" : " ") + field.name + "@" + std::to_string(field.offset);
+    return out;
+  }
+
+  Field field(std::string name, std::string type, Access access = Access::unknown) {
+    return { .name = std::move(name), .type = std::move(type), .access = access };
+  }
+
+  void reordersByAlignment() {
+    std::vector<StructExpression> structures = {
+      StructExpression("S", { field("a", "u8"), field("b", "u64"), field("c", "u8") }, false, false),
+    };
+    layout::Layouter layouter(structures, false);
+
+    const layout::StructLayout &before = find(layouter.getBefore(), "S");
+    check(placed(before) == "a@0 b@8 c@16", "S before: " + placed(before));
+    check(before.size == 24 && before.align == 8 && before.padding == 14, "S before size");
+
+    const layout::StructLayout &after = find(layouter.getAfter(), "S");
+    check(placed(after) == "b@0 a@8 c@9", "S after: " + placed(after));
+    check(after.size == 16 && after.align == 8 && after.padding == 6, "S after size");
+  }
+
+  void hotOnlyOrdersUnderSplitCold() {
+    std::vector<StructExpression> structures = {
+      StructExpression("S", { field("a", "u8", Access::hot), field("b", "u64"), field("c", "u8") }, 
+          false, false),
+    };
+    layout::Layouter layouter(structures, false);
+
+    const layout::StructLayout &after = find(layouter.getAfter(), "S");
+    check(placed(after) == "b@0 a@8 c@9", "$hot without split_cold: " + placed(after));
+    check(after.size == 16, "$hot without split_cold size");
+  }
+
+  void fixedLayoutsKeepTheirOrder() {
+    std::vector<StructExpression> structures = {
+      StructExpression("Pub", { field("a", "u8"), field("b", "u64") }, true, false),
+      StructExpression("Abi", { field("a", "u8"), field("b", "u32") }, false, true),
+    };
+    layout::Layouter layouter(structures, true);
+
+    check(placed(find(layouter.getAfter(), "Pub")) == "a@0 b@8", "pub reordered");
+    check(placed(find(layouter.getAfter(), "Abi")) == "a@0 b@4", "$abi reordered");
+  }
+
+  void splitsColdFields() {
+    std::vector<StructExpression> structures = {
+      StructExpression("S", { 
+          field("c", "u64", Access::cold), field("d", "u64", Access::cold), field("b", "u16"), 
+          field("a", "u8", Access::hot) 
+      }, false, false),
+    };
+    layout::Layouter layouter(structures, true);
+
+    const layout::StructLayout &after = find(layouter.getAfter(), "S");
+    check(placed(after) == "a@0 b@2 cold@8", "S split: " + placed(after));
+    check(after.size == 16 && after.cold == "S.cold", "S split size");
+
+    const layout::StructLayout &cold = find(layouter.getAfter(), "S.cold");
+    check(placed(cold) == "c@0 d@8" && cold.size == 16, "S.cold: " + placed(cold));
+    check(structures.size() == 2, "cold part appended");
+  }
+
+  void keepsColdFieldsThePointerDoesntPayFor() {
+    // split, S would be a@0 e@2 b@8 d@16 cold@32, 40 bytes.
+    std::vector<StructExpression> structures = {
+      StructExpression("S", { 
+          field("a", "u8", Access::hot), field("b", "u64"), field("c", "u8", Access::cold), 
+          field("d", "Inner"), field("e", "u16") 
+      }, false, false),
+      StructExpression("Inner", { field("x", "u64"), field("y", "u64") }, false, false),
+    };
+    layout::Layouter layouter(structures, true);
+
+    const layout::StructLayout &after = find(layouter.getAfter(), "S");
+    check(placed(after) == "a@0 c@1 e@2 b@8 d@16", "S kept: " + placed(after));
+    check(after.size == 32 && after.cold.empty(), "S kept size");
+    check(after.split_size == 40 && after.hot_loss == 0, "S kept report");
+    check(structures.size() == 2, "S.cold appended");
+  }
+
+  void hotFieldsLeaveNoHole() {
+    std::vector<StructExpression> structures = {
+      StructExpression("S", { 
+          field("a", "u8", Access::hot), field("b", "u64"), field("c", "u64", Access::cold),
+          field("d", "u64", Access::cold), field("e", "u16"), field("f", "u32")
+      }, false, false),
+    };
+    layout::Layouter layouter(structures, true);
+
+    const layout::StructLayout &after = find(layouter.getAfter(), "S");
+    check(placed(after) == "a@0 e@2 f@4 b@8 cold@16", "S filled: " + placed(after));
+    check(after.size == 24 && after.padding == 1 && after.hot_loss == 0, "S filled size");
+  }
+
+  void reportsWhatHotFirstCosts() {
+    // Three can't go into the hole before b, ordered by alignment alone
+    // S is b@0 a@2 t@3 in 6 bytes.
+    std::vector<StructExpression> structures = {
+      StructExpression("S", { field("a", "u8", Access::hot), field("b", "u16"), field("t", "Three") },
+          false, false),
+      StructExpression("Three", { field("x", "u8"), field("y", "u8"), field("z", "u8") }, 
+          false, false),
+    };
+    layout::Layouter layouter(structures, true);
+
+    const layout::StructLayout &after = find(layouter.getAfter(), "S");
+    check(placed(after) == "a@0 b@2 t@4", "S hot: " + placed(after));
+    check(after.size == 8 && after.hot_loss == 2, "S hot loss");
+  }
+
+  void nestedStructsUseTheirNewAlignment() {
+    // splitting Inner adds a pointer, so its alignment goes from 4 to 8
+    // and Outer has to order it first.
+    std::vector<StructExpression> structures = {
+      StructExpression("Outer", { field("p", "u32"), field("i", "Inner"), field("q", "u8") }, 
+          false, false),
+      StructExpression("Inner", { 
+          field("w", "u32", Access::cold), field("x", "u32", Access::cold), 
+          field("y", "u32", Access::cold), field("z", "u32", Access::cold), field("a", "u16") 
+      }, false, false),
+    };
+    layout::Layouter layouter(structures, true);
+
+    const layout::StructLayout &inner = find(layouter.getAfter(), "Inner");
+    check(inner.size == 16 && inner.align == 8, "Inner after split");
+
+    const layout::StructLayout &outer = find(layouter.getAfter(), "Outer");
+    check(placed(outer) == "i@0 p@16 q@20", "Outer: " + placed(outer));
+    check(outer.size == 24 && outer.padding == 3, "Outer size");
+  }
+
+  void rejectsRecursiveStructs() {
+    std::vector<StructExpression> structures = {
+      StructExpression("A", { field("b", "B") }, false, false),
+      StructExpression("B", { field("a", "A") }, false, false),
+    };
+    bool thrown = false;
+    try {
+      layout::Layouter layouter(structures, false);
+    } catch(layout::LayoutException &) {
+      thrown = true;
+    }
+    check(thrown, "recursive structs accepted");
+  }
+} // anonymous
+
+int main() {
+  reordersByAlignment();
+  hotOnlyOrdersUnderSplitCold();
+  fixedLayoutsKeepTheirOrder();
+  splitsColdFields();
+  keepsColdFieldsThePointerDoesntPayFor();
+  hotFieldsLeaveNoHole();
+  reportsWhatHotFirstCosts();
+  nestedStructsUseTheirNewAlignment();
+  rejectsRecursiveStructs();
+  return failures == 0 ? 0 : 1;
+}
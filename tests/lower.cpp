@@ -0,0 +1,275 @@
+// instruction sequences out of nukac::lower::Lowerer for defer, errdefer,
+// try and return, written out and parsed, and what sema says about them.
+
+#include <cstdio>
+#include <format>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/lexer.hpp"
+#include "../src/lower.hpp"
+#include "../src/sema.hpp"
+
+namespace {
+  using namespace nukac;
+  using lower::Statement;
+  using Kind = Statement::Kind;
+
+  int failures = 0;
+
+  // expressions are opaque to the Lowerer, these only tell them apart.
+  std::map<const parser::ast::Expression *, std::string> names;
+
+  const parser::ast::Expression *expression(const std::string &name) {
+    static std::vector<std::unique_ptr<parser::ast::Expression>> owned;
+    owned.push_back(std::make_unique<parser::ast::ReferenceExpression>(name));
+    names[owned.back().get()] = name;
+    return owned.back().get();
+  }
+
+  Statement eval(const std::string &name) {
+    return { .kind = Kind::expression, .expression = expression(name) };
+  }
+
+  Statement deferred(Kind kind, std::vector<Statement> body) {
+    return { .kind = kind, .body = std::move(body) };
+  }
+
+  // one instruction per line, with the expression it evaluates if any.
+  std::string lowered(const std::vector<Statement> &body) {
+    lower::Lowerer lowerer(body);
+    std::ostringstream out;
+    for(const lower::Instruction &instruction: lowerer.getInstructions()) {
+      out << instruction;
+      if(instruction.expression) out << " " << names.at(instruction.expression);
+      out << "\n";
+    }
+    return out.str();
+  }
+
+  void check(const std::string &what, const std::vector<Statement> &body, const std::string &expected) {
+    const std::string got = lowered(body);
+    if(got == expected) return;
+    std::printf("FAIL: %s\nexpected:\n%sgot:\n%s", what.c_str(), expected.c_str(), got.c_str());
+    failures++;
+  }
+
+  void defersRunInReverseAtTheEndOfTheirBlock() {
+    check("defer", {
+      deferred(Kind::defer, { eval("a") }),
+      deferred(Kind::defer, { eval("b") }),
+      eval("x"),
+    },
+      "eval x\n"
+      "eval b\n"
+      "eval a\n"
+      "return_ok\n");
+  }
+
+  void errdefersOnlyRunOnErrorExits() {
+    check("errdefer on success", {
+      deferred(Kind::errdefer, { eval("e") }),
+      { .kind = Kind::return_ok, .expression = expression("r") },
+    },
+      "eval_result r\n"
+      "return_ok\n");
+
+    check("errdefer on error", {
+      deferred(Kind::defer, { eval("d") }),
+      deferred(Kind::errdefer, { eval("e") }),
+      { .kind = Kind::return_error, .error_tag = 3 },
+    },
+      "eval e\n"
+      "eval d\n"
+      "return_error 3\n");
+  }
+
+  void returnEvaluatesBeforeDefers() {
+    check("return value", {
+      deferred(Kind::defer, { eval("d") }),
+      { .kind = Kind::return_ok, .expression = expression("r") },
+    },
+      "eval_result r\n"
+      "eval d\n"
+      "return_ok\n");
+  }
+
+  void tryBranchesAroundThePropagation() {
+    check("try", {
+      deferred(Kind::defer, { eval("d") }),
+      deferred(Kind::errdefer, { eval("e") }),
+      { .kind = Kind::try_call, .expression = expression("f") },
+      { .kind = Kind::return_ok, .expression = expression("r") },
+    },
+      "eval_try f\n"
+      "branch_ok L0\n"
+      "eval e\n"
+      "eval d\n"
+      "return_error propagate\n"
+      "L0:\n"
+      "eval_result r\n"
+      "eval d\n"
+      "return_ok\n");
+  }
+
+  void nestedBlocksCleanUpTheirOwnDefers() {
+    check("nested", {
+      deferred(Kind::defer, { eval("outer") }),
+      { .kind = Kind::block, .body = {
+        deferred(Kind::defer, { eval("inner") }),
+        { .kind = Kind::try_call, .expression = expression("f") },
+      }},
+      eval("x"),
+    },
+      "eval_try f\n"
+      "branch_ok L0\n"
+      "eval inner\n"
+      "eval outer\n"
+      "return_error propagate\n"
+      "L0:\n"
+      "eval inner\n"
+      "eval x\n"
+      "eval outer\n"
+      "return_ok\n");
+  }
+
+  void rejectsControlFlowInDefers() {
+    bool thrown = false;
+    try {
+      lowered({ deferred(Kind::defer, { { .kind = Kind::return_ok } }) });
+    } catch(lower::LowerException &) {
+      thrown = true;
+    }
+    if(!thrown) {
+      std::printf("FAIL: return inside a defer accepted\n");
+      failures++;
+    }
+  }
+
+  // the instructions of function in source.
+  std::string loweredSource(const std::string &source, const std::string &function) {
+    std::istringstream in(source);
+    lexer::Lexer lexer(in);
+    parser::Parser parser(lexer);
+    for(const parser::ast::Function &parsed: parser.getFunctions()) {
+      if(parsed.getPrototype().getName() != function) continue;
+      lower::Lowerer lowerer(lower::statementsOf(parsed.getBody()));
+      std::ostringstream out;
+      for(const lower::Instruction &instruction: lowerer.getInstructions()) out << instruction << "\n";
+      return out.str();
+    }
+    return "";
+  }
+
+  void parsedBodiesLower() {
+    const std::string source =
+      "error ParseError { Negative, Overflow }\n"
+      "n: i64 = 0;\n"
+      "fn ParseError!i64 step(x: i64);\n"
+      "fn ParseError!i64 chain(x: i64) {\n"
+      "  defer n = n + 1;\n"
+      "  errdefer n = n - 1;\n"
+      "  a: i64 = try step(x);\n"
+      "  {\n"
+      "    defer n = a;\n"
+      "    a = try step(a);\n"
+      "  }\n"
+      "  return a;\n"
+      "}\n"
+      "fn ParseError!void fail() {\n"
+      "  return ParseError.Overflow;\n"
+      "}\n";
+    const std::string chain = loweredSource(source, "chain");
+    const std::string expected =
+      "eval_try\n"
+      "branch_ok L0\n"
+      "eval\n"
+      "eval\n"
+      "return_error propagate\n"
+      "L0:\n"
+      "eval_try\n"
+      "branch_ok L1\n"
+      "eval\n"
+      "eval\n"
+      "eval\n"
+      "return_error propagate\n"
+      "L1:\n"
+      "eval\n"
+      "eval_result\n"
+      "eval\n"
+      "return_ok\n";
+    if(chain != expected) {
+      std::printf("FAIL: parsed chain\nexpected:\n%sgot:\n%s", expected.c_str(), chain.c_str());
+      failures++;
+    }
+
+    const std::string fail = loweredSource(source, "fail");
+    if(fail != std::format("return_error {}\n", parser::ast::errorTag("Overflow"))) {
+      std::printf("FAIL: parsed return of an error\ngot:\n%s", fail.c_str());
+      failures++;
+    }
+  }
+
+  void semaChecksErrorHandling() {
+    std::istringstream in(
+      "error ParseError { Negative }\n"
+      "error IoError { Denied }\n"
+      "fn NoSuchSet!u64 f();\n"
+      "fn ParseError!u64 step(x: u64);\n"
+      "fn IoError!u64 io();\n"
+      "fn u64 plain(x: u64) {\n"
+      "  y: u64 = try step(x);\n"
+      "  step(x);\n"
+      "  return x;\n"
+      "}\n"
+      "fn ParseError!u64 wrong(x: u64) {\n"
+      "  try io();\n"
+      "  defer return 1;\n"
+      "  return IoError.Denied;\n"
+      "}\n");
+    lexer::Lexer lexer(in);
+    parser::Parser parser(lexer);
+    sema::Analyzer analyzer(parser);
+
+    std::string all;
+    for(const sema::Diagnostic &diagnostic: analyzer.getDiagnostics()) all += diagnostic.message + "\n";
+    for(const char *wanted: {
+          "f: Unknown error set NoSuchSet.",
+          "plain: try in a function that can't fail.",
+          "plain: The error of ParseError!u64 is ignored, use try.",
+          "wrong: try passes on Denied, which isn't part of ParseError.",
+          "wrong: Only expressions can be deferred",
+          "wrong: Denied isn't part of ParseError.",
+        }) {
+      if(all.find(wanted) != std::string::npos) continue;
+      std::printf("FAIL: no diagnostic %s\ngot:\n%s", wanted, all.c_str());
+      failures++;
+    }
+  }
+
+  void errorTagsAreGlobal() {
+    const parser::ast::ErrorSet read("ReadError", { "EndOfFile", "Denied" });
+    const parser::ast::ErrorSet open("OpenError", { "Denied", "NotFound" });
+    if(read.tagOf("Denied") != open.tagOf("Denied") || read.tagOf("EndOfFile") == open.tagOf("NotFound") ||
+        read.tagOf("EndOfFile") == 0) {
+      std::printf("FAIL: error tags differ between sets\n");
+      failures++;
+    }
+  }
+} // anonymous
+
+int main() {
+  defersRunInReverseAtTheEndOfTheirBlock();
+  errdefersOnlyRunOnErrorExits();
+  returnEvaluatesBeforeDefers();
+  tryBranchesAroundThePropagation();
+  nestedBlocksCleanUpTheirOwnDefers();
+  rejectsControlFlowInDefers();
+  parsedBodiesLower();
+  semaChecksErrorHandling();
+  errorTagsAreGlobal();
+  return failures == 0 ? 0 : 1;
+}